@@ -51,6 +51,18 @@ extern char const * const BKVersion;
 #define BK_USE_64_BIT 1
 #endif
 
+#ifndef BK_USE_SIMD
+#define BK_USE_SIMD 1
+#endif
+
+#ifndef BK_USE_THREADS
+#define BK_USE_THREADS 0
+#endif
+
+#ifndef BK_USE_MMAP
+#define BK_USE_MMAP 0
+#endif
+
 /**
  * Integers and fixed point numbers.
  */
@@ -79,6 +91,7 @@ typedef uint32_t BKFUInt20;  // 12.20 fixed point
 #define BK_FRAME_MAX ((1U << (BK_FRAME_SHIFT - 1)) - 1)
 
 #define BK_MAX_CHANNELS 8
+#define BK_MAX_THREADS 64
 
 #define BK_MIN_PERIOD (BK_FINT20_SHIFT / BK_TRIANGLE_PHASES)
 #define BK_MAX_PERIOD (1 << (BK_FINT20_SHIFT + 4))
@@ -223,6 +236,10 @@ enum
 	BK_SAMPLE_RATE,
 	BK_TIME,
 	BK_PULSE_KERNEL,
+	BK_BUFFER_SIZE,
+	BK_NUM_THREADS,
+	BK_COMMAND_QUEUE_SIZE,
+	BK_BATCH_TICKS,
 };
 
 /**
@@ -317,6 +334,26 @@ enum
 	BK_EVENT_SAMPLE_RESET,
 };
 
+/**
+ * Voice pool attributes
+ */
+enum
+{
+	BK_VOICE_POOL_ATTR_TYPE = (7 << BK_ATTR_TYPE_SHIFT),
+	BK_NUM_VOICES,
+	BK_NUM_ACTIVE_VOICES,
+	BK_VOICE_STEALING,
+};
+
+/**
+ * Voice stealing modes
+ */
+enum
+{
+	BK_STEAL_OLDEST,
+	BK_STEAL_QUIETEST,
+};
+
 /**
  * Repeat options
  */
@@ -377,4 +414,10 @@ extern char const * BKStatusGetName (BKEnum status);
 #define BK_DEPRECATED_FUNC
 #endif
 
+#if __GNUC__
+#define BK_PREFETCH(ptr) __builtin_prefetch (ptr)
+#else
+#define BK_PREFETCH(ptr)
+#endif
+
 #endif /* !_BK_BASE_H_  */
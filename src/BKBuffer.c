@@ -21,6 +21,7 @@
  * IN THE SOFTWARE.
  */
 
+#include <math.h>
 #include "BKBuffer.h"
 
 extern BKBufferPulse const BKBufferStepPhasesSinc;
@@ -31,7 +32,7 @@ extern BKBufferPulse const BKBufferStepPhasesHarm;
  * Bandlimited step phases
  * Generated with `sinc_phases.c`
  */
-BKBufferPulse const BKBufferStepPhasesSinc = { .frames =
+static BKFrame const BKBufferStepFramesSinc [BK_STEP_UNIT][BK_STEP_WIDTH] =
 {
 	{     0,      0,      0,      1,     -3,      6,    -10,     16,    -25,     36,    -52,     74,   -105,    155,   -249,    519,  32746,   -488,    230,   -140,     92,    -62,     42,    -28,     18,    -11,      7,     -4,      2,      0,      0,      0, },
 	{     0,      0,      0,     -1,      3,     -6,     10,    -16,     25,    -36,     52,    -73,    105,   -154,    246,   -504,  32762,    503,   -234,    141,    -93,     63,    -42,     28,    -18,     11,     -7,      4,     -2,      0,      0,      0, },
@@ -65,13 +66,20 @@ BKBufferPulse const BKBufferStepPhasesSinc = { .frames =
 	{     0,     -1,      5,    -12,     24,    -42,     69,   -107,    159,   -228,    321,   -443,    609,   -843,   1209,  -1908,   4049,  31965,  -2956,   1412,   -840,    538,   -353,    231,   -149,     93,    -55,     31,    -16,      7,     -2,      0, },
 	{     0,     -1,      4,     -9,     17,    -30,     49,    -77,    114,   -164,    231,   -318,    437,   -604,    864,  -1356,   2826,  32321,  -2197,   1035,   -613,    392,   -256,    168,   -108,     67,    -40,     22,    -11,      5,     -1,      0, },
 	{     0,      0,      2,     -5,     10,    -18,     30,    -46,     69,    -99,    139,   -191,    262,   -362,    517,   -807,   1651,  32577,  -1368,    635,   -374,    239,   -156,    102,    -65,     40,    -24,     13,     -7,      3,      0,      0, },
-}};
+};
+
+BKBufferPulse const BKBufferStepPhasesSinc =
+{
+	.width      = BK_STEP_WIDTH,
+	.phaseShift = BK_STEP_SHIFT,
+	.frames     = BKBufferStepFramesSinc [0],
+};
 
 /**
  * Bandlimited step phases
  * Generated with `harm_phases.c`
  */
-BKBufferPulse const BKBufferStepPhasesHarm = { .frames =
+static BKFrame const BKBufferStepFramesHarm [BK_STEP_UNIT][BK_STEP_WIDTH] =
 {
 	{     0,      0,     -3,     10,    -25,     52,    -97,    168,   -276,    433,   -660,    991,  -1498,   2369,  -4328,  19208,  19287,  -4328,   2369,  -1498,    991,   -660,    433,   -276,    168,    -97,     52,    -25,     10,     -3,      0,      0, },
 	{     0,      0,     -1,      7,    -19,     42,    -83,    148,   -249,    398,   -616,    939,  -1436,   2297,  -4242,  18108,  20352,  -4368,   2416,  -1545,   1034,   -697,    464,   -300,    187,   -110,     61,    -30,     13,     -4,      1,      0, },
@@ -105,7 +113,14 @@ BKBufferPulse const BKBufferStepPhasesHarm = { .frames =
 	{     0,     -1,      6,    -16,     34,    -66,    115,   -188,    292,   -435,    628,   -887,   1242,  -1756,   2602,  -4447,  22772,  15376,  -3709,   1901,  -1120,    685,   -419,    249,   -141,     74,    -35,     14,     -3,      0,      0,      0, },
 	{     0,     -1,      4,    -13,     29,    -58,    103,   -173,    272,   -412,    602,   -860,   1217,  -1739,   2605,  -4509,  21814,  16487,  -3867,   2005,  -1197,    745,   -463,    282,   -165,     90,    -45,     20,     -7,      1,      0,      0, },
 	{     0,      0,      3,    -10,     24,    -49,     91,   -155,    250,   -384,    570,   -825,   1180,  -1705,   2581,  -4518,  20808,  17580,  -3988,   2090,  -1263,    797,   -504,    312,   -187,    106,    -56,     26,    -10,      3,      0,      0, },
-}};
+};
+
+BKBufferPulse const BKBufferStepPhasesHarm =
+{
+	.width      = BK_STEP_WIDTH,
+	.phaseShift = BK_STEP_SHIFT,
+	.frames     = BKBufferStepFramesHarm [0],
+};
 
 BKBufferPulse const * const BKBufferPulseKernels [] =
 {
@@ -113,65 +128,313 @@ BKBufferPulse const * const BKBufferPulseKernels [] =
 	[BK_PULSE_KERNEL_HARM] = &BKBufferStepPhasesHarm,
 };
 
+BKInt BKBufferPulseInit (BKBufferPulse * pulse, BKUInt width, BKUInt numPhases, double cutoff)
+{
+	BKFrame * frames;
+	BKUInt    phaseShift = 0;
+	double    phasef [BK_MAX_STEP_WIDTH];
+
+	memset (pulse, 0, sizeof (BKBufferPulse));
+
+	if (width < BK_MIN_STEP_WIDTH || width > BK_MAX_STEP_WIDTH || width % BK_MIN_STEP_WIDTH) {
+		return BK_INVALID_VALUE;
+	}
+
+	if (numPhases < BK_MIN_STEP_PHASES || numPhases > BK_MAX_STEP_PHASES || (numPhases & (numPhases - 1))) {
+		return BK_INVALID_VALUE;
+	}
+
+	if (!(cutoff > 0.0 && cutoff <= 1.0)) {
+		return BK_INVALID_VALUE;
+	}
+
+	while ((1U << phaseShift) < numPhases)
+		phaseShift ++;
+
+	frames = malloc (numPhases * width * sizeof (BKFrame));
+
+	if (frames == NULL) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	// same calculation as in `sinc_phases.c`
+	for (BKUInt phase = 0; phase < numPhases; phase ++) {
+		BKFrame * step = & frames [phase * width];
+		double    sumf = 0.0;
+		BKInt     sum  = 0;
+
+		for (BKUInt i = 0; i < width; i ++) {
+			double delta  = 1.0;
+			double iphase = (double) i - (width / 2) - ((double) phase / numPhases) + (1.0 / numPhases / 2);
+			double w      = i + 0.5;
+
+			iphase *= cutoff;
+
+			// prevent division by zero
+			if (iphase != 0.0) {
+				delta = sin (iphase * M_PI) / (iphase * M_PI);
+			}
+
+			// apply Blackman window
+			delta *= 0.42 - 0.5 * cos (2 * M_PI * w / width) + 0.08 * cos (4 * M_PI * w / width);
+
+			phasef [i] = delta;
+			sumf += delta;
+		}
+
+		// normalize step
+		for (BKUInt i = 0; i < width; i ++) {
+			step [i] = phasef [i] / sumf * BK_FRAME_MAX;
+			sum += step [i];
+		}
+
+		// correct round-off error
+		step [width / 2] += (BK_FRAME_MAX - sum);
+	}
+
+	pulse -> width      = width;
+	pulse -> phaseShift = phaseShift;
+	pulse -> frames     = frames;
+	pulse -> data       = frames;
+
+	return 0;
+}
+
+void BKBufferPulseDispose (BKBufferPulse * pulse)
+{
+	free (pulse -> data);
+	memset (pulse, 0, sizeof (BKBufferPulse));
+}
+
+BKInt BKBufferPulseIsValid (BKBufferPulse const * pulse)
+{
+	if (pulse -> frames == NULL) {
+		return 0;
+	}
+
+	if (pulse -> width < BK_MIN_STEP_WIDTH || pulse -> width > BK_MAX_STEP_WIDTH || pulse -> width % BK_MIN_STEP_WIDTH) {
+		return 0;
+	}
+
+	if (pulse -> phaseShift < 1 || (1U << pulse -> phaseShift) > BK_MAX_STEP_PHASES) {
+		return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * Get ring buffer size needed to read `size` frames at once
+ */
+static BKUInt BKBufferRingSize (BKUInt size)
+{
+	BKUInt ringSize = 1;
+
+	size += BK_BUFFER_CAPACITY + BK_MAX_STEP_WIDTH;
+
+	while (ringSize < size)
+		ringSize <<= 1;
+
+	return ringSize;
+}
+
 BKInt BKBufferInit (BKBuffer * buf)
 {
 	memset (buf, 0, sizeof (BKBuffer));
-	BKBufferClear (buf);
 
 	buf -> pulse = &BKBufferStepPhasesHarm;
+	buf -> funcs = BKBufferGetFuncs (BK_BUFFER_FUNCS_SCALAR);
+
+	return BKBufferSetSize (buf, BK_DEFAULT_BUFFER_SIZE);
+}
+
+BKInt BKBufferSetSize (BKBuffer * buf, BKUInt size)
+{
+	BKInt * frames;
+	BKUInt  ringSize, copySize, overflowOffset;
+
+	if (size < 1 || size > BK_MAX_BUFFER_SIZE) {
+		return BK_INVALID_VALUE;
+	}
+
+	ringSize = BKBufferRingSize (size);
+
+	if (ringSize == buf -> size) {
+		return 0;
+	}
+
+	frames = calloc (ringSize + BK_MAX_STEP_WIDTH, sizeof (BKInt));
+
+	if (frames == NULL) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	// copy frames beginning at read position
+	if (buf -> frames) {
+		copySize = BKMin (buf -> size, ringSize);
+
+		for (BKUInt i = 0; i < copySize; i ++)
+			frames [i] = buf -> frames [(buf -> offset + i) & (buf -> size - 1)];
+
+		// overflow belongs to the beginning of the old ring buffer
+		overflowOffset = buf -> size - buf -> offset;
+
+		for (BKUInt i = 0; i < BK_MAX_STEP_WIDTH; i ++)
+			frames [(overflowOffset + i) & (ringSize - 1)] += buf -> frames [buf -> size + i];
+
+		free (buf -> frames);
+	}
+
+	buf -> frames = frames;
+	buf -> size   = ringSize;
+	buf -> offset = 0;
 
 	return 0;
 }
 
 void BKBufferDispose (BKBuffer * buf)
 {
-	BKBufferClear (buf);
+	free (buf -> frames);
+	memset (buf, 0, sizeof (BKBuffer));
+}
+
+/**
+ * Add pulses which were written past the end of the ring buffer to its
+ * beginning
+ */
+static void BKBufferFoldOverflow (BKBuffer * buf)
+{
+	BKInt * overflow = & buf -> frames [buf -> size];
+
+	for (BKInt i = 0; i < BK_MAX_STEP_WIDTH; i ++) {
+		buf -> frames [i] += overflow [i];
+		overflow [i] = 0;
+	}
+}
+
+/**
+ * Apply high pass filter and accumulate `count` frames into `amps`
+ * Clears the frames for the next round
+ */
+static BKInt BKBufferIntegrate (BKInt frames [], BKInt amps [], BKUInt count, BKInt accum)
+{
+	for (BKUInt i = 0; i < count; i ++) {
+		accum -= (accum >> (BK_INT_SHIFT - BK_HIGH_PASS_SHIFT));  // apply high pass filter
+		accum += frames [i];                                      // accumulate
+		frames [i] = 0;                                           // clear for next round
+		amps [i] = accum;
+	}
+
+	return accum;
 }
 
 BKInt BKBufferRead (BKBuffer * buf, BKFrame outFrames [], BKUInt size, BKUInt interlace)
 {
-	BKInt * frames = & buf -> frames [0];
 	BKInt   accum  = buf -> accum;
-	BKUInt  bufferSize;
-	BKInt   amp;
+	BKUInt  offset = buf -> offset;
+	BKUInt  remaining, count;
+	BKInt   amps [BK_BUFFER_READ_BLOCK];
+	BKFrame clamped [BK_BUFFER_READ_BLOCK];
 
 	interlace = BKMax (interlace, 1);          // step must be at least 1
 	size      = BKMin (size, buf -> capacity); // can only read available frames
 
-	while (frames < & buf -> frames [size]) {
-		accum -= (accum >> (BK_INT_SHIFT - BK_HIGH_PASS_SHIFT));  // apply high pass filter
-		accum += (* frames ++);                                   // accumulate
+	// read blocks up to wrap point at a time
+	for (remaining = size; remaining; remaining -= count) {
+		count = BKMin (remaining, buf -> size - offset);
+		count = BKMin (count, BK_BUFFER_READ_BLOCK);
+		accum = BKBufferIntegrate (& buf -> frames [offset], amps, count, accum);
 
-		amp = accum >> (BK_INT_SHIFT - BK_FRAME_SHIFT - 2);  // remove fraction
+		// write directly into `outFrames` if not interlaced
+		if (interlace == 1) {
+			buf -> funcs -> clampFrames (outFrames, amps, count);
+			outFrames += count;
+		}
+		else {
+			buf -> funcs -> clampFrames (clamped, amps, count);
 
-		// clamp
-		if ((BKFrame) amp != amp)
-			amp = (amp >> BK_FRAME_SHIFT) ^ BK_FRAME_MAX;
+			for (BKUInt i = 0; i < count; i ++) {
+				(* outFrames) = clamped [i];
+				outFrames += interlace;
+			}
+		}
 
-		// write frame
-		(* outFrames) = amp;
-		outFrames += interlace;
+		offset = (offset + count) & (buf -> size - 1);
+
+		// wrapped around
+		if (offset == 0) {
+			BKBufferFoldOverflow (buf);
+		}
 	}
 
-	bufferSize = buf -> capacity + BK_STEP_WIDTH + 1;
+	// reduce remaining capacity
+	buf -> capacity -= size;
+
+	buf -> offset = offset;
+	buf -> accum  = accum;
+	buf -> base  -= size;
+
+	return size;
+}
+
+BKInt BKBufferReadFloat (BKBuffer * buf, float outFrames [], BKUInt size, BKUInt interlace)
+{
+	BKInt  accum  = buf -> accum;
+	BKUInt offset = buf -> offset;
+	BKUInt remaining, count;
+	BKInt  amps [BK_BUFFER_READ_BLOCK];
+	float  floats [BK_BUFFER_READ_BLOCK];
+
+	interlace = BKMax (interlace, 1);          // step must be at least 1
+	size      = BKMin (size, buf -> capacity); // can only read available frames
+
+	// read blocks up to wrap point at a time
+	for (remaining = size; remaining; remaining -= count) {
+		count = BKMin (remaining, buf -> size - offset);
+		count = BKMin (count, BK_BUFFER_READ_BLOCK);
+		accum = BKBufferIntegrate (& buf -> frames [offset], amps, count, accum);
+
+		// convert directly into `outFrames` if not interlaced
+		if (interlace == 1) {
+			buf -> funcs -> convertFloat (outFrames, amps, count);
+			outFrames += count;
+		}
+		else {
+			buf -> funcs -> convertFloat (floats, amps, count);
+
+			for (BKUInt i = 0; i < count; i ++) {
+				(* outFrames) = floats [i];
+				outFrames += interlace;
+			}
+		}
+
+		offset = (offset + count) & (buf -> size - 1);
+
+		// wrapped around
+		if (offset == 0) {
+			BKBufferFoldOverflow (buf);
+		}
+	}
 
-	// move frames left
-	memmove (& buf -> frames [0], & buf -> frames [size], sizeof (BKInt) * (bufferSize - size));
-	// zero right gap
-	memset (& buf -> frames [bufferSize - size], 0, sizeof (BKInt) * size);
 	// reduce remaining capacity
 	buf -> capacity -= size;
 
-	buf -> accum = accum;
-	buf -> time -= size << BK_FINT20_SHIFT;
+	buf -> offset = offset;
+	buf -> accum  = accum;
+	buf -> base  -= size;
 
 	return size;
 }
 
 void BKBufferClear (BKBuffer * buf)
 {
-	void const * pulse = buf -> pulse;
+	if (buf -> frames) {
+		memset (buf -> frames, 0, (buf -> size + BK_MAX_STEP_WIDTH) * sizeof (BKInt));
+	}
 
-	memset (buf, 0, sizeof (BKBuffer));
-	buf -> pulse = pulse;
+	buf -> time     = 0;
+	buf -> base     = 0;
+	buf -> capacity = 0;
+	buf -> accum    = 0;
+	buf -> offset   = 0;
 }
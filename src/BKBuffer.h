@@ -33,33 +33,117 @@
 #define BK_STEP_WIDTH 32
 #define BK_HIGH_PASS_SHIFT 23
 
+/**
+ * Limits of pulse kernels created with `BKBufferPulseInit`
+ * The width has to be a multiple of `BK_MIN_STEP_WIDTH`
+ */
+#define BK_MIN_STEP_WIDTH 8
+#define BK_MAX_STEP_WIDTH 64
+#define BK_MIN_STEP_PHASES 2
+#define BK_MAX_STEP_PHASES 256
+
 #define BK_BUFFER_CAPACITY ((1 << (BK_INT_SHIFT - BK_FINT20_SHIFT)) + BK_STEP_WIDTH + 1)
 
 #if BK_BUFFER_CAPACITY > 4129
 #error Capacity exceeds 4129?
 #endif
 
+/**
+ * Default and maximum number of frames which can be read from a buffer at once
+ * The buffer reserves `BK_BUFFER_CAPACITY` additional frames for frames
+ * written ahead
+ */
+#define BK_DEFAULT_BUFFER_SIZE BK_MAX_GENERATE_SAMPLES
+#define BK_MAX_BUFFER_SIZE (1 << 20)
+
+/**
+ * Scales the accumulator to float frames in the range -1.0 to 1.0
+ * Equals the shift used by `BKBufferRead` plus the 15 bit frame range
+ */
+#define BK_BUFFER_FLOAT_SCALE (1.0f / (1U << (BK_INT_SHIFT - 3)))
+
+/**
+ * Number of frames integrated at once when reading
+ */
+#define BK_BUFFER_READ_BLOCK 256
+
 typedef struct BKBuffer      BKBuffer;
 typedef struct BKBufferPulse BKBufferPulse;
+typedef struct BKBufferFuncs BKBufferFuncs;
+
+/**
+ * Add a single pulse step of `width` frames to `frames`
+ * `width` is a multiple of `BK_MIN_STEP_WIDTH`
+ */
+typedef void (* BKBufferAddPulseFunc) (BKInt * frames, BKFrame const * phase, BKUInt width, BKFrame pulse);
+
+/**
+ * Add `count` pulses with `deltas` at time offsets `times`
+ * Adds each pulse with the kernel of `BKBufferAddPulseFunc`; only the call
+ * through the function table is saved
+ */
+typedef void (* BKBufferAddPulsesFunc) (BKBuffer * buf, BKFUInt20 const times [], BKFrame const deltas [], BKUInt count);
+
+/**
+ * Convert `count` accumulator values to float frames
+ */
+typedef void (* BKBufferConvertFloatFunc) (float outFrames [], BKInt const inFrames [], BKUInt count);
+
+/**
+ * Convert `count` accumulator values to clamped 16 bit frames
+ */
+typedef void (* BKBufferClampFramesFunc) (BKFrame outFrames [], BKInt const inFrames [], BKUInt count);
+
+/**
+ * Buffer function types
+ */
+enum
+{
+	BK_BUFFER_FUNCS_SCALAR,
+	BK_BUFFER_FUNCS_SSE2,
+	BK_BUFFER_FUNCS_AVX2,
+	BK_BUFFER_FUNCS_COUNT,
+};
 
 /**
  * Buffer
  */
 struct BKBuffer
 {
-	BKFUInt20             time;
-	BKUInt                capacity;                     // dynamic capacity
-	BKInt                 accum;                        // amplitude accumulator
-	BKInt                 frames [BK_BUFFER_CAPACITY];  // frame buffer
-	BKBufferPulse const * pulse;                        // Pulse kernel
+	BKFUInt20             time;      // time fraction after `base`
+	BKUInt                base;      // write position in frames after read position
+	BKUInt                capacity;  // dynamic capacity
+	BKInt                 accum;     // amplitude accumulator
+	BKUInt                offset;    // read position in ring buffer
+	BKUInt                size;      // ring buffer size; power of two
+	BKInt               * frames;    // ring buffer followed by `BK_MAX_STEP_WIDTH` frames of pulses crossing the wrap point
+	BKBufferPulse const * pulse;     // Pulse kernel
+	BKBufferFuncs const * funcs;     // Pulse functions
+};
+
+/**
+ * Buffer functions
+ * Each implementation must produce the same integer results
+ */
+struct BKBufferFuncs
+{
+	BKEnum                   type;
+	BKBufferAddPulseFunc     addPulse;
+	BKBufferAddPulsesFunc    addPulses;
+	BKBufferConvertFloatFunc convertFloat;
+	BKBufferClampFramesFunc  clampFrames;
 };
 
 /**
  * Buffer pulse kernel
+ * A pulse is delayed by half of `width` frames
  */
 struct BKBufferPulse
 {
-	BKFrame frames [BK_STEP_UNIT][BK_STEP_WIDTH];
+	BKUInt          width;      // number of taps per phase
+	BKUInt          phaseShift; // number of phases as power of two
+	BKFrame const * frames;     // phases of `width` taps each
+	BKFrame       * data;       // allocated frames
 };
 
 /**
@@ -67,11 +151,66 @@ struct BKBufferPulse
  */
 extern BKBufferPulse const * const BKBufferPulseKernels [];
 
+/**
+ * Create a bandlimited pulse kernel with `width` taps and `numPhases` phases
+ * The kernel is a Blackman windowed sinc with the `cutoff` frequency relative
+ * to the Nyquist frequency. A `cutoff` of 1.0 with 32 taps and 32 phases gives
+ * the same kernel as `BK_PULSE_KERNEL_SINC`
+ *
+ * `width` must be a multiple of `BK_MIN_STEP_WIDTH` up to `BK_MAX_STEP_WIDTH`
+ * `numPhases` must be a power of two between `BK_MIN_STEP_PHASES` and
+ * `BK_MAX_STEP_PHASES`
+ *
+ * The kernel can be set with `BK_PULSE_KERNEL` and has to live until it is not
+ * used by any context anymore
+ *
+ * Errors:
+ * BK_INVALID_VALUE if an argument is out of range
+ * BK_ALLOCATION_ERROR if memory could not be allocated
+ */
+extern BKInt BKBufferPulseInit (BKBufferPulse * pulse, BKUInt width, BKUInt numPhases, double cutoff);
+
+/**
+ * Dispose pulse kernel
+ */
+extern void BKBufferPulseDispose (BKBufferPulse * pulse);
+
+/**
+ * Check if `pulse` can be used by a buffer
+ */
+extern BKInt BKBufferPulseIsValid (BKBufferPulse const * pulse);
+
+/**
+ * Get buffer functions of `type`
+ * Returns NULL if the functions are not supported by the host CPU
+ */
+extern BKBufferFuncs const * BKBufferGetFuncs (BKEnum type);
+
+/**
+ * Get the fastest buffer functions supported by the host CPU
+ */
+extern BKBufferFuncs const * BKBufferGetBestFuncs (void);
+
 /**
  * Initialize buffer
+ * Uses the scalar buffer functions and holds `BK_DEFAULT_BUFFER_SIZE` frames
+ *
+ * Errors:
+ * BK_ALLOCATION_ERROR if memory could not be allocated
  */
 extern BKInt BKBufferInit (BKBuffer * buf);
 
+/**
+ * Resize buffer to be able to read `size` frames at once
+ * `size` may be between 1 and `BK_MAX_BUFFER_SIZE`
+ * Buffered frames are kept
+ *
+ * Errors:
+ * BK_INVALID_VALUE if `size` is out of range
+ * BK_ALLOCATION_ERROR if memory could not be allocated
+ */
+extern BKInt BKBufferSetSize (BKBuffer * buf, BKUInt size);
+
 /**
  * Dispose buffer
  */
@@ -82,6 +221,14 @@ extern void BKBufferDispose (BKBuffer * buf);
  */
 BK_INLINE BKInt BKBufferAddPulse (BKBuffer * buf, BKFUInt20 time, BKFrame pulse);
 
+/**
+ * Add `count` pulses at time offsets
+ * `times` and `deltas` must each contain `count` values
+ * Convenience for pulses collected in a batch; gives the same result and
+ * costs about the same as calling `BKBufferAddPulse` for each pulse
+ */
+BK_INLINE BKInt BKBufferAddPulses (BKBuffer * buf, BKFUInt20 const times [], BKFrame const deltas [], BKUInt count);
+
 /**
  * Add single frame at time offset
  */
@@ -102,6 +249,12 @@ BK_INLINE BKInt BKBufferShift (BKBuffer * buf, BKFUInt20 time);
  */
 extern BKInt BKBufferRead (BKBuffer * buf, BKFrame outFrames [], BKUInt size, BKUInt interlace);
 
+/**
+ * Read frames as float
+ * Frames are in the range -1.0 to 1.0 but are not clamped
+ */
+extern BKInt BKBufferReadFloat (BKBuffer * buf, float outFrames [], BKUInt size, BKUInt interlace);
+
 /**
  * Get current buffer size
  */
@@ -118,9 +271,9 @@ BK_INLINE BKInt BKBufferEnd (BKBuffer * buf, BKFUInt20 time)
 	BKUInt offset;
 
 	time   = buf -> time + time;
-	offset = time >> BK_FINT20_SHIFT;
+	offset = buf -> base + (time >> BK_FINT20_SHIFT);
 
-	if (offset > buf -> capacity) {
+	if ((BKInt) offset > (BKInt) buf -> capacity) {
 		buf -> capacity = offset;
 	}
 
@@ -129,22 +282,28 @@ BK_INLINE BKInt BKBufferEnd (BKBuffer * buf, BKFUInt20 time)
 
 BK_INLINE BKInt BKBufferShift (BKBuffer * buf, BKFUInt20 time)
 {
-	BKFUInt20 maxShift;
+	BKUInt offset;
 
-	maxShift = buf -> capacity << BK_FINT20_SHIFT;
+	time   = buf -> time + time;
+	offset = buf -> base + (time >> BK_FINT20_SHIFT);
 
-	if (buf -> time + time > maxShift) {
-		time = maxShift - buf -> time;
+	// not beyond capacity
+	if ((BKInt) offset >= (BKInt) buf -> capacity) {
+		buf -> base = buf -> capacity;
+		buf -> time = 0;
+	}
+	// keep frames in `base` and fraction in `time`
+	else {
+		buf -> base = offset;
+		buf -> time = time & BK_FINT20_FRAC;
 	}
-
-	buf -> time += time;
 
 	return 0;
 }
 
 BK_INLINE BKInt BKBufferSize (BKBuffer const * buf)
 {
-	return buf -> time >> BK_FINT20_SHIFT;
+	return buf -> base + (buf -> time >> BK_FINT20_SHIFT);
 }
 
 BK_INLINE BKInt BKBufferAddPulse (BKBuffer * buf, BKFUInt20 time, BKFrame pulse)
@@ -153,20 +312,26 @@ BK_INLINE BKInt BKBufferAddPulse (BKBuffer * buf, BKFUInt20 time, BKFrame pulse)
 	BKUInt offset;
 	BKInt * frames;
 	BKFrame const * phase;
+	BKBufferPulse const * kernel = buf -> pulse;
 
 	time   = buf -> time + time;
-	offset = time >> BK_FINT20_SHIFT;
+	offset = buf -> base + (time >> BK_FINT20_SHIFT);
 
-	frac = time & BK_FINT20_FRAC;               // frame fraction
-	frac >>= (BK_FINT20_SHIFT - BK_STEP_SHIFT); // step fraction
+	frac = time & BK_FINT20_FRAC;                        // frame fraction
+	frac >>= (BK_FINT20_SHIFT - kernel -> phaseShift);   // step fraction
 
-	phase  = buf -> pulse -> frames [frac];
-	frames = & buf -> frames [offset];
+	phase  = & kernel -> frames [frac * kernel -> width];
+	frames = & buf -> frames [(buf -> offset + offset) & (buf -> size - 1)];
 
 	// add step
-	for (BKInt i = 0; i < BK_STEP_WIDTH; i ++) {
-		frames [i] += (BKInt) phase [i] * pulse;
-	}
+	buf -> funcs -> addPulse (frames, phase, kernel -> width, pulse);
+
+	return 0;
+}
+
+BK_INLINE BKInt BKBufferAddPulses (BKBuffer * buf, BKFUInt20 const times [], BKFrame const deltas [], BKUInt count)
+{
+	buf -> funcs -> addPulses (buf, times, deltas, count);
 
 	return 0;
 }
@@ -176,9 +341,9 @@ BK_INLINE BKInt BKBufferAddFrame (BKBuffer * buf, BKFUInt20 time, BKFrame frame)
 	BKUInt offset;
 
 	time   = buf -> time + time;
-	offset = time >> BK_FINT20_SHIFT;
+	offset = buf -> base + (time >> BK_FINT20_SHIFT);
 
-	buf -> frames [offset] += BK_MAX_VOLUME * frame;
+	buf -> frames [(buf -> offset + offset) & (buf -> size - 1)] += BK_MAX_VOLUME * frame;
 
 	return 0;
 }
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2012-2015 Simon Schoenenberger
+ * http://blipkit.audio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "BKBuffer.h"
+
+#if BK_USE_SIMD && defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define BK_BUFFER_USE_X86 1
+#include <immintrin.h>
+#else
+#define BK_BUFFER_USE_X86 0
+#endif
+
+/**
+ * Get frames and pulse phase at time offset
+ */
+BK_INLINE BKInt * BKBufferPulseFrames (BKBuffer * buf, BKFUInt20 time, BKFrame const ** outPhase)
+{
+	BKUInt frac;
+	BKUInt offset;
+	BKBufferPulse const * kernel = buf -> pulse;
+
+	time   = buf -> time + time;
+	offset = buf -> base + (time >> BK_FINT20_SHIFT);
+
+	frac = time & BK_FINT20_FRAC;                        // frame fraction
+	frac >>= (BK_FINT20_SHIFT - kernel -> phaseShift);   // step fraction
+
+	* outPhase = & kernel -> frames [frac * kernel -> width];
+
+	return & buf -> frames [(buf -> offset + offset) & (buf -> size - 1)];
+}
+
+/**
+ * Portable implementation
+ */
+static void BKBufferAddPulseScalar (BKInt * frames, BKFrame const * phase, BKUInt width, BKFrame pulse)
+{
+	for (BKUInt i = 0; i < width; i ++) {
+		frames [i] += (BKInt) phase [i] * pulse;
+	}
+}
+
+static void BKBufferAddPulsesScalar (BKBuffer * buf, BKFUInt20 const times [], BKFrame const deltas [], BKUInt count)
+{
+	BKInt * frames;
+	BKFrame const * phase;
+	BKUInt width = buf -> pulse -> width;
+
+	for (BKUInt i = 0; i < count; i ++) {
+		frames = BKBufferPulseFrames (buf, times [i], & phase);
+		BKBufferAddPulseScalar (frames, phase, width, deltas [i]);
+	}
+}
+
+static void BKBufferConvertFloatScalar (float outFrames [], BKInt const inFrames [], BKUInt count)
+{
+	for (BKUInt i = 0; i < count; i ++) {
+		outFrames [i] = (float) inFrames [i] * BK_BUFFER_FLOAT_SCALE;
+	}
+}
+
+static void BKBufferClampFramesScalar (BKFrame outFrames [], BKInt const inFrames [], BKUInt count)
+{
+	BKInt amp;
+
+	for (BKUInt i = 0; i < count; i ++) {
+		amp = inFrames [i] >> (BK_INT_SHIFT - BK_FRAME_SHIFT - 2);  // remove fraction
+
+		// clamp
+		if ((BKFrame) amp != amp)
+			amp = (amp >> BK_FRAME_SHIFT) ^ BK_FRAME_MAX;
+
+		outFrames [i] = amp;
+	}
+}
+
+static BKBufferFuncs const BKBufferFuncsScalar =
+{
+	.type         = BK_BUFFER_FUNCS_SCALAR,
+	.addPulse     = BKBufferAddPulseScalar,
+	.addPulses    = BKBufferAddPulsesScalar,
+	.convertFloat = BKBufferConvertFloatScalar,
+	.clampFrames  = BKBufferClampFramesScalar,
+};
+
+#if BK_BUFFER_USE_X86
+
+/**
+ * SSE2 implementation
+ * Multiplies 8 phase values at once and widens the 32 bit products
+ */
+__attribute__ ((target ("sse2")))
+static void BKBufferAddPulseSSE2 (BKInt * frames, BKFrame const * phase, BKUInt width, BKFrame pulse)
+{
+	__m128i factor = _mm_set1_epi16 (pulse);
+
+	for (BKUInt i = 0; i < width; i += 8) {
+		__m128i values = _mm_loadu_si128 ((__m128i const *) & phase [i]);
+		__m128i lo     = _mm_mullo_epi16 (values, factor);
+		__m128i hi     = _mm_mulhi_epi16 (values, factor);
+		__m128i prod0  = _mm_unpacklo_epi16 (lo, hi);
+		__m128i prod1  = _mm_unpackhi_epi16 (lo, hi);
+		__m128i * out  = (__m128i *) & frames [i];
+
+		_mm_storeu_si128 (& out [0], _mm_add_epi32 (_mm_loadu_si128 (& out [0]), prod0));
+		_mm_storeu_si128 (& out [1], _mm_add_epi32 (_mm_loadu_si128 (& out [1]), prod1));
+	}
+}
+
+/**
+ * AVX2 implementation
+ * Sign extends 8 phase values at once to 32 bit before multiplying
+ */
+__attribute__ ((target ("avx2")))
+static void BKBufferAddPulseAVX2 (BKInt * frames, BKFrame const * phase, BKUInt width, BKFrame pulse)
+{
+	__m256i factor = _mm256_set1_epi32 (pulse);
+
+	for (BKUInt i = 0; i < width; i += 8) {
+		__m256i values = _mm256_cvtepi16_epi32 (_mm_loadu_si128 ((__m128i const *) & phase [i]));
+		__m256i prod   = _mm256_mullo_epi32 (values, factor);
+		__m256i * out  = (__m256i *) & frames [i];
+
+		_mm256_storeu_si256 (out, _mm256_add_epi32 (_mm256_loadu_si256 (out), prod));
+	}
+}
+
+__attribute__ ((target ("sse2")))
+static void BKBufferAddPulsesSSE2 (BKBuffer * buf, BKFUInt20 const times [], BKFrame const deltas [], BKUInt count)
+{
+	BKInt * frames;
+	BKFrame const * phase;
+	BKUInt width = buf -> pulse -> width;
+
+	for (BKUInt i = 0; i < count; i ++) {
+		frames = BKBufferPulseFrames (buf, times [i], & phase);
+		BKBufferAddPulseSSE2 (frames, phase, width, deltas [i]);
+	}
+}
+
+__attribute__ ((target ("avx2")))
+static void BKBufferAddPulsesAVX2 (BKBuffer * buf, BKFUInt20 const times [], BKFrame const deltas [], BKUInt count)
+{
+	BKInt * frames;
+	BKFrame const * phase;
+	BKUInt width = buf -> pulse -> width;
+
+	for (BKUInt i = 0; i < count; i ++) {
+		frames = BKBufferPulseFrames (buf, times [i], & phase);
+		BKBufferAddPulseAVX2 (frames, phase, width, deltas [i]);
+	}
+}
+
+/**
+ * Converts 4 values at once
+ * Scaling by a power of two is exact, so results equal the scalar version
+ */
+__attribute__ ((target ("sse2")))
+static void BKBufferConvertFloatSSE2 (float outFrames [], BKInt const inFrames [], BKUInt count)
+{
+	BKUInt i = 0;
+	__m128 scale = _mm_set1_ps (BK_BUFFER_FLOAT_SCALE);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128i values = _mm_loadu_si128 ((__m128i const *) & inFrames [i]);
+		_mm_storeu_ps (& outFrames [i], _mm_mul_ps (_mm_cvtepi32_ps (values), scale));
+	}
+
+	BKBufferConvertFloatScalar (& outFrames [i], & inFrames [i], count - i);
+}
+
+/**
+ * Converts 8 values at once
+ */
+__attribute__ ((target ("avx2")))
+static void BKBufferConvertFloatAVX2 (float outFrames [], BKInt const inFrames [], BKUInt count)
+{
+	BKUInt i = 0;
+	__m256 scale = _mm256_set1_ps (BK_BUFFER_FLOAT_SCALE);
+
+	for (; i + 8 <= count; i += 8) {
+		__m256i values = _mm256_loadu_si256 ((__m256i const *) & inFrames [i]);
+		_mm256_storeu_ps (& outFrames [i], _mm256_mul_ps (_mm256_cvtepi32_ps (values), scale));
+	}
+
+	BKBufferConvertFloatScalar (& outFrames [i], & inFrames [i], count - i);
+}
+
+/**
+ * Remove fraction of 4 values and clamp them like the scalar version
+ * Values not fitting into 16 bit become `(amp >> 16) ^ BK_FRAME_MAX`
+ */
+__attribute__ ((target ("sse2")))
+static inline __m128i BKBufferClampSSE2 (__m128i amp)
+{
+	__m128i ext, inRange, clamped;
+
+	amp     = _mm_srai_epi32 (amp, BK_INT_SHIFT - BK_FRAME_SHIFT - 2);
+	ext     = _mm_srai_epi32 (_mm_slli_epi32 (amp, BK_FRAME_SHIFT), BK_FRAME_SHIFT);
+	inRange = _mm_cmpeq_epi32 (ext, amp);
+	clamped = _mm_xor_si128 (_mm_srai_epi32 (amp, BK_FRAME_SHIFT), _mm_set1_epi32 (BK_FRAME_MAX));
+
+	return _mm_or_si128 (_mm_and_si128 (inRange, amp), _mm_andnot_si128 (inRange, clamped));
+}
+
+/**
+ * Clamps 8 values at once and packs them into 16 bit
+ * All values are in range after clamping, so packing does not saturate
+ */
+__attribute__ ((target ("sse2")))
+static void BKBufferClampFramesSSE2 (BKFrame outFrames [], BKInt const inFrames [], BKUInt count)
+{
+	BKUInt i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128i amp0 = BKBufferClampSSE2 (_mm_loadu_si128 ((__m128i const *) & inFrames [i + 0]));
+		__m128i amp1 = BKBufferClampSSE2 (_mm_loadu_si128 ((__m128i const *) & inFrames [i + 4]));
+
+		_mm_storeu_si128 ((__m128i *) & outFrames [i], _mm_packs_epi32 (amp0, amp1));
+	}
+
+	BKBufferClampFramesScalar (& outFrames [i], & inFrames [i], count - i);
+}
+
+__attribute__ ((target ("avx2")))
+static inline __m256i BKBufferClampAVX2 (__m256i amp)
+{
+	__m256i ext, inRange, clamped;
+
+	amp     = _mm256_srai_epi32 (amp, BK_INT_SHIFT - BK_FRAME_SHIFT - 2);
+	ext     = _mm256_srai_epi32 (_mm256_slli_epi32 (amp, BK_FRAME_SHIFT), BK_FRAME_SHIFT);
+	inRange = _mm256_cmpeq_epi32 (ext, amp);
+	clamped = _mm256_xor_si256 (_mm256_srai_epi32 (amp, BK_FRAME_SHIFT), _mm256_set1_epi32 (BK_FRAME_MAX));
+
+	return _mm256_blendv_epi8 (clamped, amp, inRange);
+}
+
+/**
+ * Clamps 16 values at once
+ * Packing works per 128 bit lane, so the 64 bit blocks have to be reordered
+ */
+__attribute__ ((target ("avx2")))
+static void BKBufferClampFramesAVX2 (BKFrame outFrames [], BKInt const inFrames [], BKUInt count)
+{
+	BKUInt i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m256i amp0 = BKBufferClampAVX2 (_mm256_loadu_si256 ((__m256i const *) & inFrames [i + 0]));
+		__m256i amp1 = BKBufferClampAVX2 (_mm256_loadu_si256 ((__m256i const *) & inFrames [i + 8]));
+		__m256i pack = _mm256_permute4x64_epi64 (_mm256_packs_epi32 (amp0, amp1), 0xD8);
+
+		_mm256_storeu_si256 ((__m256i *) & outFrames [i], pack);
+	}
+
+	BKBufferClampFramesScalar (& outFrames [i], & inFrames [i], count - i);
+}
+
+static BKBufferFuncs const BKBufferFuncsSSE2 =
+{
+	.type         = BK_BUFFER_FUNCS_SSE2,
+	.addPulse     = BKBufferAddPulseSSE2,
+	.addPulses    = BKBufferAddPulsesSSE2,
+	.convertFloat = BKBufferConvertFloatSSE2,
+	.clampFrames  = BKBufferClampFramesSSE2,
+};
+
+static BKBufferFuncs const BKBufferFuncsAVX2 =
+{
+	.type         = BK_BUFFER_FUNCS_AVX2,
+	.addPulse     = BKBufferAddPulseAVX2,
+	.addPulses    = BKBufferAddPulsesAVX2,
+	.convertFloat = BKBufferConvertFloatAVX2,
+	.clampFrames  = BKBufferClampFramesAVX2,
+};
+
+#endif /* BK_BUFFER_USE_X86 */
+
+BKBufferFuncs const * BKBufferGetFuncs (BKEnum type)
+{
+	BKBufferFuncs const * funcs = NULL;
+
+	switch (type) {
+		case BK_BUFFER_FUNCS_SCALAR: {
+			funcs = & BKBufferFuncsScalar;
+			break;
+		}
+#if BK_BUFFER_USE_X86
+		case BK_BUFFER_FUNCS_SSE2: {
+			if (__builtin_cpu_supports ("sse2"))
+				funcs = & BKBufferFuncsSSE2;
+			break;
+		}
+		case BK_BUFFER_FUNCS_AVX2: {
+			if (__builtin_cpu_supports ("avx2"))
+				funcs = & BKBufferFuncsAVX2;
+			break;
+		}
+#endif /* BK_BUFFER_USE_X86 */
+	}
+
+	return funcs;
+}
+
+BKBufferFuncs const * BKBufferGetBestFuncs (void)
+{
+	BKBufferFuncs const * funcs = NULL;
+
+	// search from fastest to slowest
+	for (BKInt type = BK_BUFFER_FUNCS_COUNT - 1; type >= 0 && funcs == NULL; type --)
+		funcs = BKBufferGetFuncs (type);
+
+	return funcs;
+}
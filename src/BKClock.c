@@ -22,7 +22,7 @@
  */
 
 #include "BKClock.h"
-#include "BKContext.h"
+#include "BKContext_internal.h"
 
 enum
 {
@@ -122,8 +122,14 @@ BKInt BKClockAttach (BKClock * clock, BKContext * ctx, BKClock * beforeClock)
 			beforeClock -> prevClock = clock;
 		}
 		else {
+			clock -> ctx = NULL;
 			return BK_INVALID_VALUE;
 		}
+
+		if (BKContextAttachClock (ctx, clock) != 0) {
+			BKClockDetach (clock);
+			return BK_ALLOCATION_ERROR;
+		}
 	}
 	else {
 		return BK_INVALID_STATE;
@@ -137,6 +143,8 @@ void BKClockDetach (BKClock * clock)
 	BKContext * ctx = clock -> ctx;
 
 	if (ctx) {
+		BKContextDetachClock (ctx, clock);
+
 		if (clock -> prevClock) {
 			clock -> prevClock -> nextClock = clock -> nextClock;
 		}
@@ -167,9 +175,6 @@ void BKClockReset (BKClock * clock)
 {
 	BKContext * ctx = clock -> ctx;
 
-	if (ctx)
-		ctx -> flags |= BK_CONTEXT_FLAG_CLOCK_RESET;
-
 	for (BKDivider * divider = clock -> dividers.firstDivider; divider; divider = divider -> nextDivider)
 		BKDividerReset (divider);
 
@@ -177,11 +182,23 @@ void BKClockReset (BKClock * clock)
 	clock -> counter  = 0;
 	clock -> time     = BK_TIME_ZERO;
 	clock -> nextTime = BK_TIME_ZERO;
+
+	// tick at current context time
+	if (ctx)
+		BKContextUpdateClock (ctx, clock);
 }
 
 void BKClockAdvance (BKClock * clock, BKFUInt20 period)
 {
+	BKContext * ctx = clock -> ctx;
+
+	if (ctx)
+		BKContextSyncClock (ctx, clock);
+
 	clock -> time = BKTimeAddFUInt20 (clock -> time, period);
+
+	if (ctx)
+		BKContextUpdateClock (ctx, clock);
 }
 
 BKInt BKDividerTick (BKDivider * divider, BKCallbackInfo * info)
@@ -64,11 +64,14 @@ struct BKClock
 	BKClock      * prevClock;
 	BKClock      * nextClock;
 	BKTime         period;
-	BKTime         time;
+	BKTime         time;      // updated lazily while attached
 	BKTime         nextTime;
 	BKUInt         counter;
 	BKCallback     callback;
 	BKDividerGroup dividers;
+	BKTime         dueTime;   // context time of next tick
+	BKUInt         order;     // ascending in order of clock list
+	BKUInt         heapIndex; // index in clock heap of context
 };
 
 /**
@@ -88,6 +91,7 @@ extern BKInt BKClockAlloc (BKClock ** outClock, BKTime period, BKCallback * call
  *
  * Errors:
  * BK_INVALID_STATE if clock is already attached to a context
+ * BK_ALLOCATION_ERROR if memory could not be allocated
  */
 extern BKInt BKClockAttach (BKClock * clock, BKContext * ctx, BKClock * beforeClock);
 
@@ -21,13 +21,95 @@
  * IN THE SOFTWARE.
  */
 
+#include "BKArray.h"
 #include "BKContext.h"
+#include "BKTone.h"
+#include "BKTrack_internal.h"
 #include "BKUnit.h"
+#include "BKWorkers.h"
 
 extern BKInt BKContextSetAttrInt (BKContext * ctx, BKEnum attr, BKInt value);
+extern BKInt BKContextGenerateToTimeFrames (BKContext * ctx, BKTime endTime, BKFrame frames [], BKInt (* write) (BKFrame inFrames [], BKUInt size, void * info), void * info);
+extern BKInt BKContextAttachClock (BKContext * ctx, BKClock * clock);
+extern void BKContextDetachClock (BKContext * ctx, BKClock * clock);
+extern void BKContextUpdateClock (BKContext * ctx, BKClock * clock);
+extern void BKContextSyncClock (BKContext * ctx, BKClock * clock);
 
 extern BKClass BKContextClass;
 
+#define BK_CONTEXT_SNAPSHOT_MAGIC 0x4e534b42 // "BKSN"
+
+typedef struct BKContextEvent          BKContextEvent;
+typedef struct BKContextSnapshotHeader BKContextSnapshotHeader;
+typedef struct BKContextClockState     BKContextClockState;
+typedef struct BKContextDividerState   BKContextDividerState;
+typedef struct BKContextBufferState    BKContextBufferState;
+
+/**
+ * Scheduled command
+ */
+struct BKContextEvent
+{
+	BKCommand command;
+	BKUInt    order;
+};
+
+/**
+ * Snapshot layout
+ * Followed by the context time, clock states, divider states, unit states and
+ * buffer states each followed by their frames
+ */
+struct BKContextSnapshotHeader
+{
+	BKUInt magic;
+	BKUInt size;        // total size in bytes
+	BKUInt numChannels;
+	BKUInt ringSize;    // ring buffer size of channels
+	BKUInt numClocks;
+	BKUInt numDividers;
+	BKUInt numUnits;
+	BKUInt unitsSize;   // size of all unit states in bytes
+	BKUInt deltaTime;
+	BKUInt unitTime;
+};
+
+struct BKContextClockState
+{
+	BKTime period;
+	BKTime time;
+	BKTime nextTime;
+	BKUInt counter;
+	BKUInt reserved;
+};
+
+struct BKContextDividerState
+{
+	BKInt divider;
+	BKInt counter;
+};
+
+struct BKContextBufferState
+{
+	BKFUInt20 time;
+	BKUInt    base;
+	BKUInt    capacity;
+	BKInt     accum;
+	BKUInt    numFrames; // number of following frames
+};
+
+/**
+ * Units are distributed over the threads of `workers`
+ * Thread 0 renders into the context channels and every other thread into its
+ * own channel buffers which are added to the context channels after each run
+ */
+struct BKContextWorkers
+{
+	BKWorkers   workers;
+	BKContext * ctx;
+	BKBuffer  * channels;  // `numThreads - 1` sets of `numChannels` buffers
+	BKFUInt20   endTime;
+};
+
 static BKEnum BKContextTick (BKCallbackInfo * info, BKContext * ctx)
 {
 	BKDividerTick (ctx -> beatDividers.firstDivider, info);
@@ -52,24 +134,127 @@ static void BKContextUpdateMasterClocks (BKContext * ctx)
 	BKClockInit (& ctx -> masterClock, clockPeriod, & callback);  // then advance effects
 }
 
+/**
+ * Allocate command queue with at least `size` commands
+ */
+static BKInt BKContextSetCommandQueueSize (BKContext * ctx, BKUInt size)
+{
+	BKCommand * commands;
+	BKUInt      queueSize = 1;
+
+	if (size < 1 || size > BK_MAX_COMMAND_QUEUE_SIZE) {
+		return BK_INVALID_VALUE;
+	}
+
+	while (queueSize < size)
+		queueSize <<= 1;
+
+	commands = malloc (queueSize * sizeof (BKCommand));
+
+	if (commands == NULL) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	// taking commands does not allocate events
+	if (BKArrayReserve (& ctx -> events, queueSize) != 0) {
+		free (commands);
+		return BK_ALLOCATION_ERROR;
+	}
+
+	free (ctx -> commands);
+
+	ctx -> commands      = commands;
+	ctx -> commandsSize  = queueSize;
+	ctx -> commandsWrite = 0;
+	ctx -> commandsRead  = 0;
+
+	return 0;
+}
+
+/**
+ * Get channel buffer `index` of context followed by buffers of workers
+ */
+static BKBuffer * BKContextGetBuffer (BKContext * ctx, BKUInt index)
+{
+	if (index < ctx -> numChannels) {
+		return & ctx -> channels [index];
+	}
+
+	return & ctx -> workers -> channels [index - ctx -> numChannels];
+}
+
+/**
+ * Resize all channel buffers including those of workers
+ * Buffers which are already resized are set back to the previous size on error
+ */
+static BKInt BKContextSetBufferSize (BKContext * ctx, BKUInt size)
+{
+	BKInt  res = 0;
+	BKUInt numBuffers = ctx -> numChannels;
+	BKUInt i;
+
+	if (size < BK_MAX_GENERATE_SAMPLES || size > BK_MAX_BUFFER_SIZE) {
+		return BK_INVALID_VALUE;
+	}
+
+	if (ctx -> workers) {
+		numBuffers += (ctx -> numThreads - 1) * ctx -> numChannels;
+	}
+
+	for (i = 0; i < numBuffers; i ++) {
+		if ((res = BKBufferSetSize (BKContextGetBuffer (ctx, i), size)) != 0) {
+			break;
+		}
+	}
+
+	if (res != 0) {
+		while (i > 0)
+			BKBufferSetSize (BKContextGetBuffer (ctx, -- i), ctx -> bufferSize);
+
+		return res;
+	}
+
+	ctx -> bufferSize = size;
+
+	return 0;
+}
+
 static BKInt BKContextInitGeneric (BKContext * ctx, BKUInt numChannels, BKUInt sampleRate)
 {
 	BKBuffer * channel;
+	BKBufferFuncs const * funcs;
 
 	ctx -> sampleRate  = BKClamp (sampleRate, BK_MIN_SAMPLE_RATE, BK_MAX_SAMPLE_RATE);
 	ctx -> numChannels = BKClamp (numChannels, 1, BK_MAX_CHANNELS);
-	ctx -> channels    = malloc (sizeof (BKBuffer) * ctx -> numChannels);
+	ctx -> channels    = calloc (ctx -> numChannels, sizeof (BKBuffer));
+	ctx -> tonePeriods = malloc (BK_TONE_TABLE_SIZE * sizeof (BKFUInt20));
+	ctx -> bufferSize  = BK_DEFAULT_BUFFER_SIZE;
+	ctx -> numThreads  = 1;
+	ctx -> events      = BK_ARRAY_INIT (sizeof (BKContextEvent));
+	ctx -> clocks      = BK_ARRAY_INIT (sizeof (BKClock *));
+	ctx -> units       = BK_ARRAY_INIT (sizeof (BKUnit *));
+	ctx -> unitStates  = BK_ARRAY_INIT (sizeof (BKUnitRunState));
 
 	BKContextUpdateMasterClocks (ctx);
 
-	if (ctx -> channels == NULL)
+	if (ctx -> channels == NULL || ctx -> tonePeriods == NULL)
+		return BK_ALLOCATION_ERROR;
+
+	BKTonePeriodTableInit (ctx -> tonePeriods, ctx -> sampleRate);
+
+	if (BKContextSetCommandQueueSize (ctx, BK_DEFAULT_COMMAND_QUEUE_SIZE) != 0)
 		return BK_ALLOCATION_ERROR;
 
+	// select fastest pulse functions once
+	funcs = BKBufferGetBestFuncs ();
+
 	for (BKInt i = 0; i < ctx -> numChannels; i ++) {
 		channel = & ctx -> channels [i];
 
 		if (BKBufferInit (channel) < 0)
 			return BK_ALLOCATION_ERROR;
+
+		channel -> funcs = funcs;
 	}
 
 	return 0;
@@ -101,6 +286,113 @@ extern BKInt BKContextAlloc (BKContext ** outCtx, BKUInt numChannels, BKUInt sam
 	return 0;
 }
 
+static void BKContextWorkersDispose (BKContextWorkers * workers, BKUInt numChannels)
+{
+	BKUInt numBuffers = (workers -> workers.numThreads - 1) * numChannels;
+
+	BKWorkersDispose (& workers -> workers);
+
+	if (workers -> channels) {
+		for (BKUInt i = 0; i < numBuffers; i ++)
+			BKBufferDispose (& workers -> channels [i]);
+
+		free (workers -> channels);
+	}
+
+	free (workers);
+}
+
+/**
+ * Create `numThreads` worker threads with their own channel buffers
+ */
+static BKInt BKContextSetNumThreads (BKContext * ctx, BKUInt numThreads)
+{
+	BKContextWorkers * workers;
+	BKUInt numBuffers;
+	BKInt  res;
+
+	if (numThreads < 1 || numThreads > BK_MAX_THREADS) {
+		return BK_INVALID_VALUE;
+	}
+
+	if (numThreads == ctx -> numThreads) {
+		return 0;
+	}
+
+	workers = NULL;
+
+	if (numThreads > 1) {
+		workers = calloc (1, sizeof (BKContextWorkers));
+
+		if (workers == NULL) {
+			return BK_ALLOCATION_ERROR;
+		}
+
+		workers -> ctx = ctx;
+
+		if ((res = BKWorkersInit (& workers -> workers, numThreads)) != 0) {
+			free (workers);
+			return res;
+		}
+
+		numBuffers = (numThreads - 1) * ctx -> numChannels;
+		workers -> channels = calloc (numBuffers, sizeof (BKBuffer));
+
+		if (workers -> channels == NULL) {
+			BKContextWorkersDispose (workers, ctx -> numChannels);
+			return BK_ALLOCATION_ERROR;
+		}
+
+		for (BKUInt i = 0; i < numBuffers; i ++) {
+			if ((res = BKBufferInit (& workers -> channels [i])) == 0) {
+				res = BKBufferSetSize (& workers -> channels [i], ctx -> bufferSize);
+			}
+
+			if (res != 0) {
+				BKContextWorkersDispose (workers, ctx -> numChannels);
+				return res;
+			}
+		}
+	}
+
+	if (ctx -> workers) {
+		BKContextWorkersDispose (ctx -> workers, ctx -> numChannels);
+	}
+
+	if (ctx -> ticker) {
+		BKTrackTickerDispose (ctx -> ticker);
+	}
+
+	ctx -> workers    = workers;
+	ctx -> numThreads = numThreads;
+
+	return 0;
+}
+
+/**
+ * Create or dispose the ticker of tracks
+ */
+static BKInt BKContextSetBatchTicks (BKContext * ctx, BKInt value)
+{
+	if ((value != 0) == (ctx -> ticker != NULL)) {
+		return 0;
+	}
+
+	// tracks choose how they are ticked when attaching
+	if (ctx -> firstUnit) {
+		return BK_INVALID_STATE;
+	}
+
+	if (value) {
+		return BKTrackTickerAlloc (& ctx -> ticker, ctx);
+	}
+
+	BKTrackTickerDispose (ctx -> ticker);
+	ctx -> ticker = NULL;
+
+	return 0;
+}
+
 static void BKContextDisposeObject (BKContext * ctx)
 {
 	BKUnit   * nextUnit;
@@ -122,13 +414,49 @@ static void BKContextDisposeObject (BKContext * ctx)
 		BKBufferDispose (channel);
 	}
 
+	if (ctx -> workers) {
+		BKContextWorkersDispose (ctx -> workers, ctx -> numChannels);
+	}
+
 	free (ctx -> channels);
+	free (ctx -> tonePeriods);
+	free (ctx -> commands);
+	BKArrayDispose (& ctx -> events);
+	BKArrayDispose (& ctx -> clocks);
+	BKArrayDispose (& ctx -> units);
+	BKArrayDispose (& ctx -> unitStates);
 	BKDispose (& ctx -> masterClock);
 }
 
 BKInt BKContextSetAttrInt (BKContext * ctx, BKEnum attr, BKInt value)
 {
+	BKInt res;
+
 	switch (attr) {
+		case BK_BUFFER_SIZE: {
+			if ((res = BKContextSetBufferSize (ctx, value)) != 0) {
+				return res;
+			}
+			break;
+		}
+		case BK_NUM_THREADS: {
+			if ((res = BKContextSetNumThreads (ctx, value)) != 0) {
+				return res;
+			}
+			break;
+		}
+		case BK_COMMAND_QUEUE_SIZE: {
+			if ((res = BKContextSetCommandQueueSize (ctx, value)) != 0) {
+				return res;
+			}
+			break;
+		}
+		case BK_BATCH_TICKS: {
+			if ((res = BKContextSetBatchTicks (ctx, value)) != 0) {
+				return res;
+			}
+			break;
+		}
 		case BK_ARPEGGIO_DIVIDER:
 		case BK_EFFECT_DIVIDER:
 		case BK_INSTRUMENT_DIVIDER: {
@@ -164,6 +492,22 @@ static BKInt BKContextGetAttrInt (BKContext const * ctx, BKEnum attr, BKInt * ou
 			value = ctx -> sampleRate;
 			break;
 		}
+		case BK_BUFFER_SIZE: {
+			value = ctx -> bufferSize;
+			break;
+		}
+		case BK_NUM_THREADS: {
+			value = ctx -> numThreads;
+			break;
+		}
+		case BK_COMMAND_QUEUE_SIZE: {
+			value = ctx -> commandsSize;
+			break;
+		}
+		case BK_BATCH_TICKS: {
+			value = ctx -> ticker != NULL;
+			break;
+		}
 		default: {
 			return BK_INVALID_ATTRIBUTE;
 			break;
@@ -202,6 +546,9 @@ static BKInt BKContextSetPtrObj (BKContext * ctx, BKEnum attr, void * ptr, BKSiz
 			if (!pulse) {
 				pulse = BKBufferPulseKernels [BK_PULSE_KERNEL_HARM];
 			}
+			else if (!BKBufferPulseIsValid (pulse)) {
+				return BK_INVALID_VALUE;
+			}
 
 			for (BKInt i = 0; i < ctx -> numChannels; i ++) {
 				channel = &ctx -> channels [i];
@@ -259,30 +606,51 @@ BKInt BKContextGetPtr (BKContext const * ctx, BKEnum attr, void * outPtr)
 	return BKContextGetPtrObj (ctx, attr, outPtr, 0);
 }
 
-BKInt BKContextGenerate (BKContext * ctx, BKFrame outFrames [], BKUInt size)
+/**
+ * Maximum number of frames run at once by `BKContextEnd`
+ * The end time is returned as positive `BKInt`; the other half of the
+ * `BKFUInt20` range is left for clock periods and unit times which run beyond
+ * the end time
+ */
+#define BK_MAX_RUN_SAMPLES (BK_INT_MAX >> BK_FINT20_SHIFT)
+
+/**
+ * Read `size` frames into `outFrames` beginning at frame `offset`
+ */
+typedef BKInt (* BKContextReadFunc) (BKContext * ctx, void * outFrames, BKUInt offset, BKUInt size);
+
+/**
+ * Generate frames in chunks of `bufferSize` and read them with `read`
+ */
+static BKInt BKContextGenerateChunks (BKContext * ctx, void * outFrames, BKUInt size, BKContextReadFunc read)
 {
 	BKUInt endTime;
 	BKUInt chunkSize;
+	BKUInt runSize;
 	BKUInt remainingSize;
 	BKUInt writeSize;
+	BKUInt offset;
 	BKInt  result;
 
 	remainingSize = size;
 	writeSize     = 0;
+	offset        = 0;
 
 	do {
-		chunkSize = remainingSize;
+		chunkSize = BKMin (remainingSize, ctx -> bufferSize);
 
-		if (chunkSize > BK_MAX_GENERATE_SAMPLES)
-			chunkSize = BK_MAX_GENERATE_SAMPLES;
+		// run in steps which fit into `BKFUInt20`
+		for (BKUInt runOffset = 0; runOffset < chunkSize; runOffset += runSize) {
+			runSize = BKMin (chunkSize - runOffset, BK_MAX_RUN_SAMPLES);
 
-		endTime = chunkSize << BK_FINT20_SHIFT;
-		result = BKContextEnd (ctx, endTime);
+			endTime = runSize << BK_FINT20_SHIFT;
+			result = BKContextEnd (ctx, endTime);
 
-		if (result < 0)
-			return result;
+			if (result < 0)
+				return result;
+		}
 
-		chunkSize = BKContextRead (ctx, outFrames, chunkSize);
+		chunkSize = read (ctx, outFrames, offset, chunkSize);
 
 		writeSize += chunkSize;
 
@@ -291,14 +659,64 @@ BKInt BKContextGenerate (BKContext * ctx, BKFrame outFrames [], BKUInt size)
 			chunkSize = remainingSize;
 
 		remainingSize -= chunkSize;
-		outFrames += chunkSize * ctx -> numChannels;
+		offset += chunkSize;
 	}
 	while (remainingSize);
 
 	return writeSize;
 }
 
-BKInt BKContextGenerateToTime (BKContext * ctx, BKTime endTime, BKInt (* write) (BKFrame inFrames [], BKUInt size, void * info), void * info)
+static BKInt BKContextReadChunk (BKContext * ctx, BKFrame outFrames [], BKUInt offset, BKUInt size)
+{
+	return BKContextRead (ctx, & outFrames [offset * ctx -> numChannels], size);
+}
+
+static BKInt BKContextReadPlanarChunk (BKContext * ctx, BKFrame * outFrames [], BKUInt offset, BKUInt size)
+{
+	BKFrame * channelFrames [BK_MAX_CHANNELS];
+
+	for (BKInt i = 0; i < ctx -> numChannels; i ++)
+		channelFrames [i] = & outFrames [i][offset];
+
+	return BKContextReadPlanar (ctx, channelFrames, size);
+}
+
+static BKInt BKContextReadFloatChunk (BKContext * ctx, float outFrames [], BKUInt offset, BKUInt size)
+{
+	return BKContextReadFloat (ctx, & outFrames [offset * ctx -> numChannels], size);
+}
+
+static BKInt BKContextReadFloatPlanarChunk (BKContext * ctx, float * outFrames [], BKUInt offset, BKUInt size)
+{
+	float * channelFrames [BK_MAX_CHANNELS];
+
+	for (BKInt i = 0; i < ctx -> numChannels; i ++)
+		channelFrames [i] = & outFrames [i][offset];
+
+	return BKContextReadFloatPlanar (ctx, channelFrames, size);
+}
+
+BKInt BKContextGenerate (BKContext * ctx, BKFrame outFrames [], BKUInt size)
+{
+	return BKContextGenerateChunks (ctx, outFrames, size, (BKContextReadFunc) BKContextReadChunk);
+}
+
+BKInt BKContextGeneratePlanar (BKContext * ctx, BKFrame * outFrames [], BKUInt size)
+{
+	return BKContextGenerateChunks (ctx, outFrames, size, (BKContextReadFunc) BKContextReadPlanarChunk);
+}
+
+BKInt BKContextGenerateFloat (BKContext * ctx, float outFrames [], BKUInt size)
+{
+	return BKContextGenerateChunks (ctx, outFrames, size, (BKContextReadFunc) BKContextReadFloatChunk);
+}
+
+BKInt BKContextGenerateFloatPlanar (BKContext * ctx, float * outFrames [], BKUInt size)
+{
+	return BKContextGenerateChunks (ctx, outFrames, size, (BKContextReadFunc) BKContextReadFloatPlanarChunk);
+}
+
+BKInt BKContextGenerateToTimeFrames (BKContext * ctx, BKTime endTime, BKFrame frames [], BKInt (* write) (BKFrame inFrames [], BKUInt size, void * info), void * info)
 {
 	BKInt numFrames = 0;
 	BKTime deltaTime;
@@ -319,7 +737,6 @@ BKInt BKContextGenerateToTime (BKContext * ctx, BKTime endTime, BKInt (* write)
 		// write frames if buffer filled or end time is reached
 		if (BKBufferSize (& ctx -> channels [0]) >= BK_MAX_GENERATE_SAMPLES || BKTimeIsGreaterEqual (ctx -> currentTime, endTime)) {
 			BKInt size;
-			BKFrame frames [ctx -> numChannels * BK_MAX_GENERATE_SAMPLES];
 
 			size = BKContextRead (ctx, frames, BK_MAX_GENERATE_SAMPLES);
 			numFrames += size;
@@ -332,85 +749,624 @@ BKInt BKContextGenerateToTime (BKContext * ctx, BKTime endTime, BKInt (* write)
 	return numFrames;
 }
 
-/**
- * Get next clock tick period of all clocks
- * Increment clock times by that period and set new time if some clock ticks
- */
-static BKFUInt20 BKClocksAdvance (BKContext * ctx, BKClock * clocks, BKInt * error)
+BKInt BKContextGenerateToTime (BKContext * ctx, BKTime endTime, BKInt (* write) (BKFrame inFrames [], BKUInt size, void * info), void * info)
 {
-	BKClock * clock;
-	BKTime    nextTime;
+	BKFrame frames [ctx -> numChannels * BK_MAX_GENERATE_SAMPLES];
+
+	return BKContextGenerateToTimeFrames (ctx, endTime, frames, write, info);
+}
+
+BKInt BKContextSeek (BKContext * ctx, BKTime time)
+{
+	BKUnit ** units;
 	BKTime    deltaTime;
 	BKFUInt20 period;
+	BKInt     result = 0;
 
-	do {
-		nextTime = BK_TIME_MAX;
-		ctx -> flags &= ~BK_CONTEXT_FLAG_CLOCK_RESET; // clear clock reset flag
+	if (BKTimeIsLess (time, ctx -> currentTime))
+		return BK_INVALID_VALUE;
 
-		for (clock = clocks; clock; clock = clock -> nextClock) {
-			BKClockTick (clock);
+	ctx -> flags |= BK_CONTEXT_FLAG_SEEK;
 
-			// get next time to tick
-			if (BKTimeIsLess (clock -> nextTime, nextTime))
-				nextTime = clock -> nextTime;
+	while (BKTimeIsLess (ctx -> currentTime, time)) {
+		deltaTime = BKTimeSub (time, ctx -> currentTime);
+
+		if (BKTimeIsLessFUInt20 (deltaTime, BK_INT_MAX / 3)) {
+			period = BKTimeGetFUInt20 (deltaTime);
+		}
+		else {
+			period = BK_INT_MAX / 3;
 		}
-	}
-	while (ctx -> flags & BK_CONTEXT_FLAG_CLOCK_RESET);
 
-	deltaTime = BKTimeSub (nextTime, ctx -> currentTime);
+		result = BKContextRun (ctx, period);
 
-	if (BKTimeIsLessFUInt20 (deltaTime, BK_INT_MAX / 3)) {
-		period = BKTimeGetFUInt20 (deltaTime);
-	}
-	else {
-		period = BK_INT_MAX / 3;
-	}
+		if (result < 0)
+			break;
 
-	// advance
-	for (clock = clocks; clock; clock = clock -> nextClock)
-		BKClockAdvance (clock, period);
+		// end units without shifting the channel buffers
+		ctx -> deltaTime -= period;
+		ctx -> unitTime  -= period;
 
-	ctx -> currentTime = BKTimeAddFUInt20 (ctx -> currentTime, period);
+		units = ctx -> units.items;
 
-	return period;
+		for (BKUInt i = 0; i < ctx -> units.len; i ++)
+			units [i] -> end (units [i], period);
+	}
+
+	ctx -> flags &= ~BK_CONTEXT_FLAG_SEEK;
+
+	return result < 0 ? result : 0;
 }
 
-BKInt BKContextRun (BKContext * ctx, BKFUInt20 endTime)
+/**
+ * Check if clock `a` ticks before clock `b`
+ */
+static BKInt BKContextClockIsLess (BKClock const * a, BKClock const * b)
 {
-	BKFUInt20 time, clockDelta;
-	BKUnit  * unit;
-	BKInt     result;
+	if (BKTimeIsEqual (a -> dueTime, b -> dueTime)) {
+		return a -> order < b -> order;
+	}
 
-	if (ctx -> firstClock) {
-		for (time = ctx -> deltaTime; time < endTime;) {
-			result = 0;
-			clockDelta = BKClocksAdvance (ctx, ctx -> firstClock, & result);
+	return BKTimeIsLess (a -> dueTime, b -> dueTime);
+}
 
-			if (result < 0)
-				return result;
+static void BKContextClocksSiftUp (BKContext * ctx, BKUInt index)
+{
+	BKClock ** clocks = ctx -> clocks.items;
+	BKClock  * clock  = clocks [index];
+	BKUInt     parent;
 
-			// set new end time
-			time += clockDelta;
+	while (index > 0) {
+		parent = (index - 1) / 2;
 
-			// run units
-			for (unit = ctx -> firstUnit; unit; unit = unit -> nextUnit)
-				unit -> run (unit, time);
-		}
+		if (!BKContextClockIsLess (clock, clocks [parent]))
+			break;
 
-		ctx -> deltaTime = time;
-	}
-	else {
-		// run units
-		for (unit = ctx -> firstUnit; unit; unit = unit -> nextUnit)
-			unit -> run (unit, endTime);
+		clocks [index] = clocks [parent];
+		clocks [index] -> heapIndex = index;
+		index = parent;
 	}
 
-	return endTime;
+	clocks [index] = clock;
+	clock -> heapIndex = index;
 }
 
-BKInt BKContextEnd (BKContext * ctx, BKFUInt20 endTime)
+static void BKContextClocksSiftDown (BKContext * ctx, BKUInt index)
 {
-	BKUnit   * unit;
+	BKClock ** clocks = ctx -> clocks.items;
+	BKClock  * clock  = clocks [index];
+	BKUInt     child;
+
+	while ((child = 2 * index + 1) < ctx -> clocks.len) {
+		if (child + 1 < ctx -> clocks.len && BKContextClockIsLess (clocks [child + 1], clocks [child]))
+			child ++;
+
+		if (!BKContextClockIsLess (clocks [child], clock))
+			break;
+
+		clocks [index] = clocks [child];
+		clocks [index] -> heapIndex = index;
+		index = child;
+	}
+
+	clocks [index] = clock;
+	clock -> heapIndex = index;
+}
+
+static BKInt BKContextClockIsQueued (BKContext const * ctx, BKClock const * clock)
+{
+	BKClock * const * clocks = ctx -> clocks.items;
+
+	return clock -> heapIndex < ctx -> clocks.len && clocks [clock -> heapIndex] == clock;
+}
+
+/**
+ * Set order of clock between its neighbours in the clock list
+ * Renumbers all clocks if there is no space left
+ */
+static void BKContextOrderClock (BKContext * ctx, BKClock * clock)
+{
+	BKUInt lower = clock -> prevClock ? clock -> prevClock -> order : 0;
+	BKUInt upper = clock -> nextClock ? clock -> nextClock -> order : ~0U;
+	BKUInt gap, order;
+
+	if (upper - lower > 1 && upper > lower) {
+		gap = BKMin (upper - lower, 1U << 17);
+		clock -> order = lower + gap / 2;
+		return;
+	}
+
+	gap   = ~0U / (BKUInt) (ctx -> clocks.len + 1);
+	order = 0;
+
+	// keeps heap order as relative order does not change
+	for (BKClock * other = ctx -> firstClock; other; other = other -> nextClock) {
+		order += gap;
+		other -> order = order;
+	}
+}
+
+BKInt BKContextAttachClock (BKContext * ctx, BKClock * clock)
+{
+	BKClock ** item = BKArrayPush (& ctx -> clocks);
+
+	if (item == NULL) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	(* item) = clock;
+	clock -> heapIndex = (BKUInt) ctx -> clocks.len - 1;
+
+	BKContextOrderClock (ctx, clock);
+	BKContextUpdateClock (ctx, clock);
+
+	return 0;
+}
+
+void BKContextDetachClock (BKContext * ctx, BKClock * clock)
+{
+	BKClock ** clocks = ctx -> clocks.items;
+	BKUInt     index  = clock -> heapIndex;
+
+	if (!BKContextClockIsQueued (ctx, clock)) {
+		return;
+	}
+
+	clocks [index] = clocks [-- ctx -> clocks.len];
+
+	if (index < ctx -> clocks.len) {
+		BKContextClocksSiftUp (ctx, index);
+		BKContextClocksSiftDown (ctx, clocks [index] -> heapIndex);
+	}
+}
+
+void BKContextUpdateClock (BKContext * ctx, BKClock * clock)
+{
+	if (!BKContextClockIsQueued (ctx, clock)) {
+		return;
+	}
+
+	clock -> dueTime = BKTimeAdd (ctx -> currentTime, BKTimeSub (clock -> nextTime, clock -> time));
+
+	BKContextClocksSiftUp (ctx, clock -> heapIndex);
+	BKContextClocksSiftDown (ctx, clock -> heapIndex);
+}
+
+void BKContextSyncClock (BKContext * ctx, BKClock * clock)
+{
+	if (!BKContextClockIsQueued (ctx, clock)) {
+		return;
+	}
+
+	clock -> time = BKTimeSub (clock -> nextTime, BKTimeSub (clock -> dueTime, ctx -> currentTime));
+}
+
+/**
+ * Tick clocks which are due and get period to next tick
+ * Clocks ticking at the same time are ticked in order of the clock list
+ */
+static BKFUInt20 BKClocksAdvance (BKContext * ctx, BKInt * error)
+{
+	BKClock * clock;
+	BKTime    nextTime;
+	BKTime    deltaTime;
+	BKFUInt20 period;
+
+	while (ctx -> clocks.len) {
+		clock = * (BKClock **) ctx -> clocks.items;
+
+		if (BKTimeIsGreater (clock -> dueTime, ctx -> currentTime))
+			break;
+
+		BKContextSyncClock (ctx, clock);
+
+		// tick clock if its time was advanced beyond `nextTime`
+		clock -> nextTime = clock -> time;
+
+		BKClockTick (clock);
+		BKContextUpdateClock (ctx, clock);
+	}
+
+	if (ctx -> clocks.len) {
+		nextTime = (* (BKClock **) ctx -> clocks.items) -> dueTime;
+	}
+	else {
+		nextTime = BK_TIME_MAX;
+	}
+
+	deltaTime = BKTimeSub (nextTime, ctx -> currentTime);
+
+	if (BKTimeIsLessFUInt20 (deltaTime, BK_INT_MAX / 3)) {
+		period = BKTimeGetFUInt20 (deltaTime);
+	}
+	else {
+		period = BK_INT_MAX / 3;
+	}
+
+	ctx -> currentTime = BKTimeAddFUInt20 (ctx -> currentTime, period);
+
+	return period;
+}
+
+/**
+ * Set channel buffers of worker threads to the state of the context channels
+ */
+static void BKContextWorkersBegin (BKContext * ctx)
+{
+	BKBuffer * channel;
+	BKBuffer * workerChannel;
+	BKContextWorkers * workers = ctx -> workers;
+
+	for (BKUInt t = 1; t < ctx -> numThreads; t ++) {
+		for (BKUInt i = 0; i < ctx -> numChannels; i ++) {
+			channel       = & ctx -> channels [i];
+			workerChannel = & workers -> channels [(t - 1) * ctx -> numChannels + i];
+
+			workerChannel -> time     = channel -> time;
+			workerChannel -> base     = channel -> base;
+			workerChannel -> capacity = channel -> capacity;
+			workerChannel -> accum    = channel -> accum;
+			workerChannel -> offset   = channel -> offset;
+			workerChannel -> pulse    = channel -> pulse;
+			workerChannel -> funcs    = channel -> funcs;
+		}
+	}
+}
+
+/**
+ * Add frames written by worker threads to the context channels
+ * Only frames after the write position may have been written
+ */
+static void BKContextWorkersEnd (BKContext * ctx)
+{
+	BKUInt     start, count, mask;
+	BKBuffer * channel;
+	BKBuffer * workerChannel;
+	BKContextWorkers * workers = ctx -> workers;
+
+	for (BKUInt t = 1; t < ctx -> numThreads; t ++) {
+		for (BKUInt i = 0; i < ctx -> numChannels; i ++) {
+			channel       = & ctx -> channels [i];
+			workerChannel = & workers -> channels [(t - 1) * ctx -> numChannels + i];
+
+			mask  = channel -> size - 1;
+			start = channel -> offset + channel -> base;
+			count = BK_MAX_STEP_WIDTH + 1;
+
+			if ((BKInt) workerChannel -> capacity > (BKInt) channel -> base) {
+				count += workerChannel -> capacity - channel -> base;
+			}
+
+			count = BKMin (count, channel -> size);
+
+			for (BKUInt j = 0; j < count; j ++) {
+				BKUInt k = (start + j) & mask;
+
+				channel -> frames [k] += workerChannel -> frames [k];
+				workerChannel -> frames [k] = 0;
+			}
+
+			// pulses crossing the wrap point
+			for (BKUInt j = channel -> size; j < channel -> size + BK_MAX_STEP_WIDTH; j ++) {
+				channel -> frames [j] += workerChannel -> frames [j];
+				workerChannel -> frames [j] = 0;
+			}
+
+			if ((BKInt) workerChannel -> capacity > (BKInt) channel -> capacity) {
+				channel -> capacity = workerChannel -> capacity;
+			}
+		}
+	}
+
+	BKUnit ** units = ctx -> units.items;
+
+	for (BKUInt i = 0; i < ctx -> units.len; i ++)
+		units [i] -> channels = ctx -> channels;
+}
+
+/**
+ * Run the `index`th of `numThreads` contiguous ranges of units
+ *
+ * Threads do not write into the same cache lines of `unitStates` this way
+ */
+static void BKContextWorkersRunUnits (BKContextWorkers * workers, BKUInt index)
+{
+	BKContext * ctx        = workers -> ctx;
+	BKUnit   ** units      = ctx -> units.items;
+	BKUInt      numUnits   = ctx -> units.len;
+	BKUInt      numThreads = workers -> workers.numThreads;
+	BKBuffer  * channels   = ctx -> channels;
+
+	if (index > 0) {
+		channels = & workers -> channels [(index - 1) * ctx -> numChannels];
+	}
+
+	for (BKUInt i = index * numUnits / numThreads; i < (index + 1) * numUnits / numThreads; i ++) {
+		units [i] -> channels = channels;
+		units [i] -> run (units [i], workers -> endTime);
+	}
+}
+
+/**
+ * Run all units to `endTime`
+ */
+static void BKContextRunUnits (BKContext * ctx, BKFUInt20 endTime)
+{
+	BKUnit  * unit;
+	BKUnit ** units;
+	BKContextWorkers * workers = ctx -> workers;
+
+	if (workers == NULL) {
+		for (BKUInt i = 0; i < ctx -> units.len; i ++) {
+			// units may be attached or detached by sample callbacks
+			units = ctx -> units.items;
+			unit  = units [i];
+
+			if (i + 1 < ctx -> units.len)
+				BK_PREFETCH (units [i + 1]);
+
+			unit -> run (unit, endTime);
+			units = ctx -> units.items;
+
+			// run unit moved to index of detached unit
+			if (i < ctx -> units.len && units [i] != unit)
+				i --;
+		}
+
+		// units woken while running begin at the previous time
+		ctx -> unitTime = endTime;
+
+		return;
+	}
+
+	workers -> endTime = endTime;
+
+	// sample callbacks must not change `units` while workers read it
+	ctx -> flags |= BK_CONTEXT_FLAG_WORKERS;
+	BKWorkersRun (& workers -> workers, (BKWorkersFunc) BKContextWorkersRunUnits, workers);
+	ctx -> flags &= ~BK_CONTEXT_FLAG_WORKERS;
+
+	ctx -> unitTime = endTime;
+}
+
+BKInt BKContextPushCommand (BKContext * ctx, void * object, BKEnum attr, BKInt value, BKTime time)
+{
+	BKCommand * command;
+	BKUInt      writeIndex = ctx -> commandsWrite;
+	BKUInt      readIndex  = __atomic_load_n (& ctx -> commandsRead, __ATOMIC_ACQUIRE);
+
+	if (writeIndex - readIndex >= ctx -> commandsSize) {
+		return BK_INVALID_STATE;
+	}
+
+	command = & ctx -> commands [writeIndex & (ctx -> commandsSize - 1)];
+
+	command -> object = object;
+	command -> attr   = attr;
+	command -> value  = value;
+	command -> time   = time;
+
+	// publish command
+	__atomic_store_n (& ctx -> commandsWrite, writeIndex + 1, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+/**
+ * Check if event `a` is applied before event `b`
+ */
+BK_INLINE BKInt BKContextEventIsLess (BKContextEvent const * a, BKContextEvent const * b)
+{
+	if (BKTimeIsEqual (a -> command.time, b -> command.time)) {
+		return (BKInt) (a -> order - b -> order) < 0;
+	}
+
+	return BKTimeIsLess (a -> command.time, b -> command.time);
+}
+
+/**
+ * Move event at `index` down the heap
+ */
+static void BKContextEventsSiftDown (BKContext * ctx, BKUSize index)
+{
+	BKContextEvent * events = ctx -> events.items;
+	BKContextEvent   event  = events [index];
+	BKUSize          child;
+
+	while ((child = 2 * index + 1) < ctx -> events.len) {
+		if (child + 1 < ctx -> events.len && BKContextEventIsLess (& events [child + 1], & events [child]))
+			child ++;
+
+		if (!BKContextEventIsLess (& events [child], & event))
+			break;
+
+		events [index] = events [child];
+		index = child;
+	}
+
+	events [index] = event;
+}
+
+/**
+ * Add event to heap
+ * Does not allocate memory if space is reserved
+ */
+static BKInt BKContextEventsPush (BKContext * ctx, void * object, BKEnum attr, BKInt value, BKTime time)
+{
+	BKContextEvent * events;
+	BKContextEvent   event;
+	BKUSize          index, parent;
+
+	if (BKArrayPush (& ctx -> events) == NULL) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	event.command.object = object;
+	event.command.attr   = attr;
+	event.command.value  = value;
+	event.command.time   = time;
+	event.order          = ctx -> eventOrder ++;
+
+	events = ctx -> events.items;
+	index  = ctx -> events.len - 1;
+
+	// move up the heap
+	while (index > 0) {
+		parent = (index - 1) / 2;
+
+		if (!BKContextEventIsLess (& event, & events [parent]))
+			break;
+
+		events [index] = events [parent];
+		index = parent;
+	}
+
+	events [index] = event;
+
+	return 0;
+}
+
+BKInt BKContextScheduleAttr (BKContext * ctx, void * object, BKEnum attr, BKInt value, BKTime time)
+{
+	// keep space for commands taken while rendering
+	if (BKArrayReserve (& ctx -> events, ctx -> commandsSize + 1) != 0) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	return BKContextEventsPush (ctx, object, attr, value, time);
+}
+
+void BKContextUnscheduleObject (BKContext * ctx, void * object)
+{
+	BKContextEvent * events = ctx -> events.items;
+	BKUSize          len = 0;
+
+	for (BKUSize i = 0; i < ctx -> events.len; i ++) {
+		if (events [i].command.object != object)
+			events [len ++] = events [i];
+	}
+
+	ctx -> events.len = len;
+
+	// rebuild heap
+	for (BKUSize i = len / 2; i > 0; i --)
+		BKContextEventsSiftDown (ctx, i - 1);
+}
+
+/**
+ * Remove first event from the heap
+ */
+static void BKContextEventsPop (BKContext * ctx)
+{
+	BKContextEvent * events = ctx -> events.items;
+
+	events [0] = events [-- ctx -> events.len];
+
+	if (ctx -> events.len > 1)
+		BKContextEventsSiftDown (ctx, 0);
+}
+
+/**
+ * Schedule commands pushed by the control thread
+ */
+static void BKContextTakeCommands (BKContext * ctx)
+{
+	BKCommand * command;
+	BKUInt      readIndex  = ctx -> commandsRead;
+	BKUInt      writeIndex = __atomic_load_n (& ctx -> commandsWrite, __ATOMIC_ACQUIRE);
+
+	for (; readIndex != writeIndex; readIndex ++) {
+		command = & ctx -> commands [readIndex & (ctx -> commandsSize - 1)];
+
+		// keep command in queue
+		if (BKContextEventsPush (ctx, command -> object, command -> attr, command -> value, command -> time) != 0)
+			break;
+	}
+
+	// release slots
+	__atomic_store_n (& ctx -> commandsRead, readIndex, __ATOMIC_RELEASE);
+}
+
+/**
+ * Run units from `startTime` to `endTime` and apply scheduled commands in
+ * between
+ * `baseTime` is the context time at buffer time 0
+ */
+static void BKContextRunEvents (BKContext * ctx, BKTime baseTime, BKFUInt20 startTime, BKFUInt20 endTime)
+{
+	BKContextEvent * event;
+	BKTime           eventTime;
+	BKFUInt20        time;
+
+	while (ctx -> events.len) {
+		event     = ctx -> events.items;
+		eventTime = BKTimeSub (event -> command.time, baseTime);
+
+		if (BKTimeIsGreaterEqual (eventTime, BKTimeMake (0, endTime)))
+			break;
+
+		// run units to event
+		if (BKTimeIsGreater (eventTime, BKTimeMake (0, startTime))) {
+			time = BKTimeGetFUInt20 (eventTime);
+			BKContextRunUnits (ctx, time);
+			startTime = time;
+		}
+
+		BKSetAttr (event -> command.object, event -> command.attr, event -> command.value);
+		BKContextEventsPop (ctx);
+	}
+
+	BKContextRunUnits (ctx, endTime);
+}
+
+BKInt BKContextRun (BKContext * ctx, BKFUInt20 endTime)
+{
+	BKFUInt20 time, clockDelta;
+	BKInt     result;
+
+	BKContextTakeCommands (ctx);
+
+	if (ctx -> workers)
+		BKContextWorkersBegin (ctx);
+
+	if (ctx -> firstClock) {
+		for (time = ctx -> deltaTime; time < endTime;) {
+			result = 0;
+			clockDelta = BKClocksAdvance (ctx, & result);
+
+			if (result < 0) {
+				if (ctx -> workers)
+					BKContextWorkersEnd (ctx);
+
+				return result;
+			}
+
+			// set new end time
+			time += clockDelta;
+
+			// run units; `currentTime` is the context time at `time`
+			BKContextRunEvents (ctx, BKTimeSubFUInt20 (ctx -> currentTime, time), time - clockDelta, time);
+		}
+
+		ctx -> deltaTime = time;
+	}
+	else if (ctx -> deltaTime < endTime) {
+		// run units; advance time like clocks
+		BKContextRunEvents (ctx, BKTimeSubFUInt20 (ctx -> currentTime, ctx -> deltaTime), ctx -> deltaTime, endTime);
+
+		ctx -> currentTime = BKTimeAddFUInt20 (ctx -> currentTime, endTime - ctx -> deltaTime);
+		ctx -> deltaTime   = endTime;
+	}
+
+	if (ctx -> workers)
+		BKContextWorkersEnd (ctx);
+
+	return endTime;
+}
+
+BKInt BKContextEnd (BKContext * ctx, BKFUInt20 endTime)
+{
+	BKUnit  ** units;
 	BKBuffer * channel;
 	BKInt      result;
 
@@ -421,20 +1377,267 @@ BKInt BKContextEnd (BKContext * ctx, BKFUInt20 endTime)
 
 	// end clock time
 	ctx -> deltaTime -= endTime;
+	ctx -> unitTime  -= endTime;
 
 	// end units
-	for (unit = ctx -> firstUnit; unit; unit = unit -> nextUnit)
-		unit -> end (unit, endTime);
+	units = ctx -> units.items;
+
+	for (BKUInt i = 0; i < ctx -> units.len; i ++)
+		units [i] -> end (units [i], endTime);
 
-	// shift channel buffers
+	// shift channel buffers; advanced also if all units are sleeping
 	for (BKInt i = 0; i < ctx -> numChannels; i ++) {
 		channel = & ctx -> channels [i];
+		BKBufferEnd (channel, endTime);
 		BKBufferShift (channel, endTime);
 	}
 
 	return endTime;
 }
 
+/**
+ * Count objects and unit state sizes of snapshot
+ */
+static void BKContextSnapshotCount (BKContext * ctx, BKContextSnapshotHeader * header)
+{
+	BKDivider * divider;
+
+	memset (header, 0, sizeof (*header));
+
+	header -> magic       = BK_CONTEXT_SNAPSHOT_MAGIC;
+	header -> numChannels = ctx -> numChannels;
+	header -> ringSize    = ctx -> channels [0].size;
+
+	for (BKClock * clock = ctx -> firstClock; clock; clock = clock -> nextClock) {
+		header -> numClocks ++;
+
+		for (divider = clock -> dividers.firstDivider; divider; divider = divider -> nextDivider)
+			header -> numDividers ++;
+	}
+
+	for (divider = ctx -> beatDividers.firstDivider; divider; divider = divider -> nextDivider)
+		header -> numDividers ++;
+
+	for (divider = ctx -> effectDividers.firstDivider; divider; divider = divider -> nextDivider)
+		header -> numDividers ++;
+
+	for (BKUnit * unit = ctx -> firstUnit; unit; unit = unit -> nextUnit) {
+		header -> numUnits ++;
+		header -> unitsSize += unit -> copyState (unit, NULL, 0);
+	}
+}
+
+/**
+ * Get number of buffer frames which may contain pulses
+ */
+static BKUInt BKContextSnapshotNumFrames (BKBuffer const * channel)
+{
+	return BKMin (channel -> capacity + BK_MAX_STEP_WIDTH + 1, channel -> size);
+}
+
+/**
+ * Copy divider states of group from or to `ptr`
+ */
+static char * BKContextCopyDividers (BKDividerGroup * group, char * ptr, BKInt restore)
+{
+	BKContextDividerState state;
+
+	for (BKDivider * divider = group -> firstDivider; divider; divider = divider -> nextDivider) {
+		if (restore) {
+			memcpy (& state, ptr, sizeof (state));
+			divider -> divider = state.divider;
+			divider -> counter = state.counter;
+		}
+		else {
+			state.divider = divider -> divider;
+			state.counter = divider -> counter;
+			memcpy (ptr, & state, sizeof (state));
+		}
+
+		ptr += sizeof (state);
+	}
+
+	return ptr;
+}
+
+/**
+ * Copy clock, divider and unit states from or to `ptr`
+ */
+static char * BKContextCopyState (BKContext * ctx, char * ptr, BKInt restore)
+{
+	BKContextClockState clockState;
+
+	for (BKClock * clock = ctx -> firstClock; clock; clock = clock -> nextClock) {
+		if (restore) {
+			memcpy (& clockState, ptr, sizeof (clockState));
+			clock -> period   = clockState.period;
+			clock -> time     = clockState.time;
+			clock -> nextTime = clockState.nextTime;
+			clock -> counter  = clockState.counter;
+			BKContextUpdateClock (ctx, clock);
+		}
+		else {
+			BKContextSyncClock (ctx, clock);
+			memset (& clockState, 0, sizeof (clockState));
+			clockState.period   = clock -> period;
+			clockState.time     = clock -> time;
+			clockState.nextTime = clock -> nextTime;
+			clockState.counter  = clock -> counter;
+			memcpy (ptr, & clockState, sizeof (clockState));
+		}
+
+		ptr += sizeof (clockState);
+	}
+
+	for (BKClock * clock = ctx -> firstClock; clock; clock = clock -> nextClock)
+		ptr = BKContextCopyDividers (& clock -> dividers, ptr, restore);
+
+	ptr = BKContextCopyDividers (& ctx -> beatDividers, ptr, restore);
+	ptr = BKContextCopyDividers (& ctx -> effectDividers, ptr, restore);
+
+	for (BKUnit * unit = ctx -> firstUnit; unit; unit = unit -> nextUnit)
+		ptr += unit -> copyState (unit, ptr, restore);
+
+	return ptr;
+}
+
+BKInt BKContextSnapshotSize (BKContext * ctx)
+{
+	BKContextSnapshotHeader header;
+
+	BKContextSnapshotCount (ctx, & header);
+
+	return sizeof (header) + sizeof (ctx -> currentTime)
+		+ header.numClocks * sizeof (BKContextClockState)
+		+ header.numDividers * sizeof (BKContextDividerState)
+		+ header.unitsSize
+		+ header.numChannels * (sizeof (BKContextBufferState) + header.ringSize * sizeof (BKInt));
+}
+
+BKInt BKContextSnapshot (BKContext * ctx, void * data, BKSize size)
+{
+	BKContextSnapshotHeader header;
+	BKContextBufferState    bufferState;
+	BKBuffer * channel;
+	BKInt    * frames;
+	BKUInt     mask, overflowOffset;
+	BKSize     totalSize;
+	char     * ptr = data;
+
+	BKContextSnapshotCount (ctx, & header);
+
+	totalSize = sizeof (header) + sizeof (ctx -> currentTime)
+		+ header.numClocks * sizeof (BKContextClockState)
+		+ header.numDividers * sizeof (BKContextDividerState)
+		+ header.unitsSize
+		+ header.numChannels * sizeof (BKContextBufferState);
+
+	for (BKInt i = 0; i < ctx -> numChannels; i ++)
+		totalSize += BKContextSnapshotNumFrames (& ctx -> channels [i]) * sizeof (BKInt);
+
+	if (data == NULL || size < totalSize) {
+		return BK_INVALID_VALUE;
+	}
+
+	header.size      = (BKUInt) totalSize;
+	header.deltaTime = ctx -> deltaTime;
+	header.unitTime  = ctx -> unitTime;
+
+	memcpy (ptr, & header, sizeof (header));
+	ptr += sizeof (header);
+	memcpy (ptr, & ctx -> currentTime, sizeof (ctx -> currentTime));
+	ptr += sizeof (ctx -> currentTime);
+
+	ptr = BKContextCopyState (ctx, ptr, 0);
+
+	for (BKInt i = 0; i < ctx -> numChannels; i ++) {
+		channel = & ctx -> channels [i];
+
+		bufferState.time      = channel -> time;
+		bufferState.base      = channel -> base;
+		bufferState.capacity  = channel -> capacity;
+		bufferState.accum     = channel -> accum;
+		bufferState.numFrames = BKContextSnapshotNumFrames (channel);
+
+		memcpy (ptr, & bufferState, sizeof (bufferState));
+		ptr += sizeof (bufferState);
+		frames = (BKInt *) ptr;
+
+		// frames are stored starting at the read position
+		mask = channel -> size - 1;
+
+		for (BKUInt j = 0; j < bufferState.numFrames; j ++)
+			frames [j] = channel -> frames [(channel -> offset + j) & mask];
+
+		// pulses crossing the wrap point
+		overflowOffset = channel -> size - channel -> offset;
+
+		for (BKUInt j = 0; j < BK_MAX_STEP_WIDTH && overflowOffset + j < bufferState.numFrames; j ++)
+			frames [overflowOffset + j] += channel -> frames [channel -> size + j];
+
+		ptr += bufferState.numFrames * sizeof (BKInt);
+	}
+
+	return (BKInt) totalSize;
+}
+
+BKInt BKContextRestore (BKContext * ctx, void const * data, BKSize size)
+{
+	BKContextSnapshotHeader header, snapshotHeader;
+	BKContextBufferState    bufferState;
+	BKBuffer * channel;
+	char     * ptr = (char *) data;
+
+	if (data == NULL || size < sizeof (header)) {
+		return BK_INVALID_VALUE;
+	}
+
+	memcpy (& snapshotHeader, ptr, sizeof (snapshotHeader));
+	ptr += sizeof (snapshotHeader);
+
+	if (snapshotHeader.magic != BK_CONTEXT_SNAPSHOT_MAGIC || snapshotHeader.size > size) {
+		return BK_INVALID_VALUE;
+	}
+
+	BKContextSnapshotCount (ctx, & header);
+
+	// attached objects have to be the same
+	if (snapshotHeader.numChannels != header.numChannels
+		|| snapshotHeader.ringSize != header.ringSize
+		|| snapshotHeader.numClocks != header.numClocks
+		|| snapshotHeader.numDividers != header.numDividers
+		|| snapshotHeader.numUnits != header.numUnits
+		|| snapshotHeader.unitsSize != header.unitsSize) {
+		return BK_INVALID_STATE;
+	}
+
+	memcpy (& ctx -> currentTime, ptr, sizeof (ctx -> currentTime));
+	ptr += sizeof (ctx -> currentTime);
+	ctx -> deltaTime = snapshotHeader.deltaTime;
+	ctx -> unitTime  = snapshotHeader.unitTime;
+
+	ptr = BKContextCopyState (ctx, ptr, 1);
+
+	for (BKInt i = 0; i < ctx -> numChannels; i ++) {
+		channel = & ctx -> channels [i];
+
+		memcpy (& bufferState, ptr, sizeof (bufferState));
+		ptr += sizeof (bufferState);
+
+		channel -> time     = bufferState.time;
+		channel -> base     = bufferState.base;
+		channel -> capacity = bufferState.capacity;
+		channel -> accum    = bufferState.accum;
+		channel -> offset   = 0;
+
+		memset (channel -> frames, 0, (channel -> size + BK_MAX_STEP_WIDTH) * sizeof (BKInt));
+		memcpy (channel -> frames, ptr, BKMin (bufferState.numFrames, channel -> size) * sizeof (BKInt));
+		ptr += bufferState.numFrames * sizeof (BKInt);
+	}
+
+	return 0;
+}
+
 BKInt BKContextSize (BKContext const * ctx)
 {
 	// assuming every buffer has the same size
@@ -455,6 +1658,46 @@ BKInt BKContextRead (BKContext * ctx, BKFrame outFrames [], BKUInt size)
 	return size;
 }
 
+BKInt BKContextReadPlanar (BKContext * ctx, BKFrame * outFrames [], BKUInt size)
+{
+	BKBuffer * channel;
+
+	// read channels
+	for (BKInt i = 0; i < ctx -> numChannels; i ++) {
+		channel = & ctx -> channels [i];
+		size = BKBufferRead (channel, outFrames [i], size, 1);
+	}
+
+	return size;
+}
+
+BKInt BKContextReadFloat (BKContext * ctx, float outFrames [], BKUInt size)
+{
+	BKBuffer * channel;
+
+	// read channels
+	for (BKInt i = 0; i < ctx -> numChannels; i ++) {
+		channel = & ctx -> channels [i];
+		// interlace into `outFrames`
+		size = BKBufferReadFloat (channel, & outFrames [i], size, ctx -> numChannels);
+	}
+
+	return size;
+}
+
+BKInt BKContextReadFloatPlanar (BKContext * ctx, float * outFrames [], BKUInt size)
+{
+	BKBuffer * channel;
+
+	// read channels
+	for (BKInt i = 0; i < ctx -> numChannels; i ++) {
+		channel = & ctx -> channels [i];
+		size = BKBufferReadFloat (channel, outFrames [i], size, 1);
+	}
+
+	return size;
+}
+
 void BKContextReset (BKContext * ctx)
 {
 	BKUnit   * unit;
@@ -463,6 +1706,9 @@ void BKContextReset (BKContext * ctx)
 
 	ctx -> deltaTime   = 0;
 	ctx -> currentTime = BK_TIME_ZERO;
+	ctx -> unitTime    = 0;
+
+	BKArrayEmpty (& ctx -> events);
 
 	for (unit = ctx -> firstUnit; unit; unit = unit -> nextUnit) {
 		if (unit -> reset)
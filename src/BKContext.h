@@ -25,6 +25,7 @@
 #define _BK_CONTEXT_H_
 
 #include "BKObject.h"
+#include "BKArray.h"
 #include "BKBuffer.h"
 #include "BKClock.h"
 
@@ -32,7 +33,16 @@
  * The context buffers the samples generated by units
  */
 
-typedef struct BKUnit BKUnit;
+typedef struct BKUnit           BKUnit;
+typedef struct BKContextWorkers BKContextWorkers;
+typedef struct BKCommand        BKCommand;
+typedef struct BKTrackTicker    BKTrackTicker;
+
+/**
+ * Default number of commands which can be queued
+ */
+#define BK_DEFAULT_COMMAND_QUEUE_SIZE 256
+#define BK_MAX_COMMAND_QUEUE_SIZE (1 << 16)
 
 typedef BKEnum (* BKGenerateCallback) (BKTime * nextTime, void * info);
 
@@ -45,21 +55,36 @@ enum
 enum
 {
 	BK_CONTEXT_FLAG_CLOCK_RESET = 1 << 0,
+	BK_CONTEXT_FLAG_SEEK        = 1 << 1,
+	BK_CONTEXT_FLAG_WORKERS     = 1 << 2, // units are run by worker threads
 	BK_CONTEXT_FLAG_COPY_MASK   = 0,
 };
 
+/**
+ * Attribute change of an object at context time `time`
+ */
+struct BKCommand
+{
+	void * object;
+	BKEnum attr;
+	BKInt  value;
+	BKTime time;
+};
+
 struct BKContext
 {
 	BKObject object;
 	BKUInt   flags;
 
 	// settings
-	BKUInt numChannels;
-	BKUInt sampleRate;
+	BKUInt      numChannels;
+	BKUInt      sampleRate;
+	BKFUInt20 * tonePeriods; // periods of `BKTonePeriodTableInit` for `sampleRate`
 
 	// run time
 	BKFUInt20 deltaTime;
 	BKTime    currentTime;
+	BKFUInt20 unitTime; // time units have been run to
 
 	// master clocks
 	BKClock masterClock;
@@ -71,13 +96,34 @@ struct BKContext
 	// linked clocks
 	BKClock * firstClock;
 	BKClock * lastClock;
+	BKArray   clocks; // min heap ordered by due time and order of clock list
 
 	// linked units
 	BKUnit * firstUnit;
 	BKUnit * lastUnit;
+	BKArray  units;      // attached units which are not sleeping
+	BKArray  unitStates; // run states of `units` at the same index
+
+	// tracks ticked together if BK_BATCH_TICKS is set
+	BKTrackTicker * ticker;
 
 	// channels
 	BKBuffer * channels;
+	BKUInt     bufferSize;
+
+	// threads rendering units
+	BKUInt             numThreads;
+	BKContextWorkers * workers;
+
+	// commands pushed by a single control thread
+	BKCommand * commands;
+	BKUInt      commandsSize;  // power of two
+	BKUInt      commandsWrite; // written only by the control thread
+	BKUInt      commandsRead;  // written only by the rendering thread
+
+	// scheduled commands
+	BKArray events;     // min heap ordered by time and order of scheduling
+	BKUInt  eventOrder; // incremented with each scheduled command
 };
 
 /**
@@ -100,6 +146,34 @@ extern BKInt BKContextAlloc (BKContext ** outCtx, BKUInt numChannels, BKUInt sam
 /**
  * Set attribute
  *
+ * BK_BUFFER_SIZE
+ *   Number of frames generated before reading them from the channel buffers
+ *   May be between BK_MAX_GENERATE_SAMPLES and BK_MAX_BUFFER_SIZE
+ *   Larger values amortize the costs of each read for long renders
+ * BK_NUM_THREADS
+ *   Number of threads used to run the attached units between clock ticks
+ *   May be between 1 and BK_MAX_THREADS; default is 1
+ *   Each additional thread renders into its own channel buffers which are
+ *   added to the context channels after each run. The output is the same
+ *   for any number of threads
+ *   Sample callbacks of units may be called from any of these threads. If
+ *   more than one thread is used, they must not attach, detach or wake units
+ *   or set attributes which do; attaching and waking units fails with
+ *   BK_INVALID_STATE and detaching is ignored while the threads run
+ * BK_COMMAND_QUEUE_SIZE
+ *   Number of commands which can be queued with `BKContextPushCommand`
+ *   May be between 1 and BK_MAX_COMMAND_QUEUE_SIZE and is rounded up to the
+ *   next power of two; default is BK_DEFAULT_COMMAND_QUEUE_SIZE
+ *   Space for as many scheduled events is reserved so taking commands
+ *   while rendering does not allocate memory
+ *   Queued commands are discarded
+ *   Must not be set while another thread pushes commands
+ * BK_BATCH_TICKS
+ *   If set to 1 tracks attached to the context are ticked together by a
+ *   single divider instead of each by its own divider; default is 0
+ *   The effect states of all tracks are kept in arrays and each effect is
+ *   stepped for all tracks in one loop. The output is the same
+ *   May only be changed while no units are attached
  * BK_ARPEGGIO_DIVIDER
  *   Set divider value for arpeggio step for all attached tracks
  * BK_EFFECT_DIVIDER
@@ -110,6 +184,7 @@ extern BKInt BKContextAlloc (BKContext ** outCtx, BKUInt numChannels, BKUInt sam
  * Errors:
  * BK_INVALID_ATTRIBUTE if attribute is unkown
  * BK_INVALID_VALUE if value is invalid for this attribute
+ * BK_INVALID_STATE if BK_BATCH_TICKS is changed while units are attached
  */
 extern BKInt BKContextSetAttr (BKContext * ctx, BKEnum attr, BKInt value) BK_DEPRECATED_FUNC ("Use 'BKSetAttr' instead");
 
@@ -118,6 +193,10 @@ extern BKInt BKContextSetAttr (BKContext * ctx, BKEnum attr, BKInt value) BK_DEP
  *
  * BK_SAMPLE_RATE
  * BK_NUM_CHANNELS
+ * BK_BUFFER_SIZE
+ * BK_NUM_THREADS
+ * BK_COMMAND_QUEUE_SIZE
+ * BK_BATCH_TICKS
  *
  * Errors:
  * BK_INVALID_ATTRIBUTE if attribute is unkown
@@ -155,11 +234,41 @@ extern BKInt BKContextGetPtr (BKContext const * ctx, BKEnum attr, void * outPtr)
  * Generate frames
  * Channels are interlaced in the form LRLRLR
  * `outFrames` must have enough space for size * (number of channels) frames
+ * Frames are read in chunks of the size set with BK_BUFFER_SIZE
  *
  * No errors defined
  */
 extern BKInt BKContextGenerate (BKContext * ctx, BKFrame outFrames [], BKUInt size);
 
+/**
+ * Generate frames
+ * `outFrames` contains a pointer for each channel with enough space for
+ * `size` frames
+ *
+ * No errors defined
+ */
+extern BKInt BKContextGeneratePlanar (BKContext * ctx, BKFrame * outFrames [], BKUInt size);
+
+/**
+ * Generate float frames
+ * Channels are interlaced in the form LRLRLR
+ * `outFrames` must have enough space for size * (number of channels) frames
+ * Frames are in the range -1.0 to 1.0 but are not clamped
+ *
+ * No errors defined
+ */
+extern BKInt BKContextGenerateFloat (BKContext * ctx, float outFrames [], BKUInt size);
+
+/**
+ * Generate float frames
+ * `outFrames` contains a pointer for each channel with enough space for
+ * `size` frames
+ * Frames are in the range -1.0 to 1.0 but are not clamped
+ *
+ * No errors defined
+ */
+extern BKInt BKContextGenerateFloatPlanar (BKContext * ctx, float * outFrames [], BKUInt size);
+
 /**
  * Generate frames to specified time
  * `write` is called every time new frames are available from the buffer
@@ -170,6 +279,83 @@ extern BKInt BKContextGenerate (BKContext * ctx, BKFrame outFrames [], BKUInt si
  */
 extern BKInt BKContextGenerateToTime (BKContext * ctx, BKTime endTime, BKInt (* write) (BKFrame inFrames [], BKUInt size, void * info), void * info);
 
+/**
+ * Advance context to specified time without generating frames
+ *
+ * Clocks, dividers, tracks, scheduled commands and unit phases advance as if
+ * frames were generated, but no pulses are written. Frames already in the
+ * buffer are kept and frames generated afterwards continue from them
+ *
+ * Errors:
+ * BK_INVALID_VALUE if `time` is before the current time
+ */
+extern BKInt BKContextSeek (BKContext * ctx, BKTime time);
+
+/**
+ * Get maximum number of bytes needed by `BKContextSnapshot` for the currently
+ * attached objects
+ */
+extern BKInt BKContextSnapshotSize (BKContext * ctx);
+
+/**
+ * Write state of context and all attached clocks, dividers, units, tracks and
+ * channel buffers into `data` which has space for `size` bytes
+ * Returns the number of bytes written
+ *
+ * The snapshot does not contain references to objects like samples,
+ * waveforms or instruments and does not contain scheduled commands. It can
+ * only be restored in a context with the same objects attached in the same
+ * order and should not be used across different builds
+ *
+ * Errors:
+ * BK_INVALID_VALUE if `data` is too small
+ */
+extern BKInt BKContextSnapshot (BKContext * ctx, void * data, BKSize size);
+
+/**
+ * Restore state written by `BKContextSnapshot`
+ *
+ * Errors:
+ * BK_INVALID_VALUE if `data` is not a snapshot
+ * BK_INVALID_STATE if attached objects do not match the snapshot
+ */
+extern BKInt BKContextRestore (BKContext * ctx, void const * data, BKSize size);
+
+/**
+ * Queue setting attribute `attr` of `object` to `value` at context time `time`
+ *
+ * This function does not block and may be called from another thread while
+ * the context is rendering, but only from one thread at a time. Commands are
+ * taken at the beginning of `BKContextRun` and scheduled like with
+ * `BKContextScheduleAttr`. Use BK_TIME_ZERO to apply a command as soon as
+ * possible
+ *
+ * Errors:
+ * BK_INVALID_STATE if the queue is full
+ */
+extern BKInt BKContextPushCommand (BKContext * ctx, void * object, BKEnum attr, BKInt value, BKTime time);
+
+/**
+ * Set attribute `attr` of `object` to `value` with `BKSetAttr` at context
+ * time `time`
+ *
+ * Units are run exactly to `time` before the attribute is set. Commands with
+ * the same time are applied in the order they were scheduled. Commands with a
+ * time already passed are applied with the next run
+ *
+ * `object` has to stay valid until the command is applied or removed with
+ * `BKContextUnscheduleObject`
+ *
+ * Errors:
+ * BK_ALLOCATION_ERROR if memory could not be allocated
+ */
+extern BKInt BKContextScheduleAttr (BKContext * ctx, void * object, BKEnum attr, BKInt value, BKTime time);
+
+/**
+ * Remove all scheduled commands of `object`
+ */
+extern void BKContextUnscheduleObject (BKContext * ctx, void * object);
+
 /**
  * Run context to specific time
  */
@@ -193,8 +379,33 @@ extern BKInt BKContextSize (BKContext const * ctx);
  */
 extern BKInt BKContextRead (BKContext * ctx, BKFrame outFrames [], BKUInt size);
 
+/**
+ * Read from channels
+ * `outFrames` contains a pointer for each channel with enough space for
+ * `size` frames
+ * Get a maximum of `size` frames
+ */
+extern BKInt BKContextReadPlanar (BKContext * ctx, BKFrame * outFrames [], BKUInt size);
+
+/**
+ * Read float frames from channels
+ * Channels are interlaced in the form LRLRLR
+ * `outFrames` must have enough space for size * (number of channels) frames
+ * Get a maximum of `size` frames
+ */
+extern BKInt BKContextReadFloat (BKContext * ctx, float outFrames [], BKUInt size);
+
+/**
+ * Read float frames from channels
+ * `outFrames` contains a pointer for each channel with enough space for
+ * `size` frames
+ * Get a maximum of `size` frames
+ */
+extern BKInt BKContextReadFloatPlanar (BKContext * ctx, float * outFrames [], BKUInt size);
+
 /**
  * Reset all units, buffers and clocks
+ * Scheduled commands are removed
  */
 extern void BKContextReset (BKContext * ctx);
 
@@ -25,6 +25,7 @@
 #define _BK_CONTEXT_INTERN_H_
 
 #include "BKContext.h"
+#include "BKTone.h"
 
 /**
  */
@@ -34,4 +35,51 @@ extern BKInt BKContextSetAttrInt (BKContext * ctx, BKEnum attr, BKInt value);
  */
 extern BKInt BKContextGetAttrInt (BKContext const * ctx, BKEnum attr, BKInt * outValue);
 
+/**
+ * Same as `BKContextGenerateToTime` but uses `frames` to read into
+ * `frames` must have space for `numChannels * BK_MAX_GENERATE_SAMPLES` frames
+ */
+extern BKInt BKContextGenerateToTimeFrames (BKContext * ctx, BKTime endTime, BKFrame frames [], BKInt (* write) (BKFrame inFrames [], BKUInt size, void * info), void * info);
+
+/**
+ * Insert linked clock into clock heap
+ *
+ * Errors:
+ * BK_ALLOCATION_ERROR if memory could not be allocated
+ */
+extern BKInt BKContextAttachClock (BKContext * ctx, BKClock * clock);
+
+/**
+ * Remove clock from clock heap
+ */
+extern void BKContextDetachClock (BKContext * ctx, BKClock * clock);
+
+/**
+ * Update due time of clock after changing `time` or `nextTime`
+ */
+extern void BKContextUpdateClock (BKContext * ctx, BKClock * clock);
+
+/**
+ * Set `time` of clock to current context time
+ */
+extern void BKContextSyncClock (BKContext * ctx, BKClock * clock);
+
+/**
+ * Get period of note `tone` rounded to 1/64 semitone
+ * Same as `BKTonePeriodLookup` with the sample rate of the context
+ */
+BK_INLINE BKFUInt20 BKContextTonePeriod (BKContext const * ctx, BKFInt20 tone);
+
+
+BK_INLINE BKFUInt20 BKContextTonePeriod (BKContext const * ctx, BKFInt20 tone)
+{
+	BKInt index;
+
+	tone  = BKClamp (tone, BK_MIN_NOTE << BK_FINT20_SHIFT, BK_MAX_NOTE << BK_FINT20_SHIFT);
+	index = (tone - (BK_MIN_NOTE << BK_FINT20_SHIFT) + (1 << (BK_FINT20_SHIFT - BK_TONE_TABLE_SHIFT - 1)))
+		>> (BK_FINT20_SHIFT - BK_TONE_TABLE_SHIFT);
+
+	return ctx -> tonePeriods [index];
+}
+
 #endif /* ! _BK_CONTEXT_INTERN_H_ */
@@ -24,9 +24,14 @@
 #include <fcntl.h>
 #include <math.h>
 #include <unistd.h>
+#include "BKBase.h"
 #include "BKData_internal.h"
 #include "BKWaveFileReader.h"
 #include "BKTone.h"
+#if BK_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 extern BKClass const BKDataClass;
 
@@ -138,6 +143,21 @@ static void BKDataResetStates (BKData * data, BKEnum event)
 	data -> object.flags &= ~BKObjectFlagLocked;
 }
 
+/**
+ * Remove file mapping after frames have been replaced
+ */
+static void BKDataUnmap (BKData * data)
+{
+#if BK_USE_MMAP
+	if (data -> mapping) {
+		munmap (data -> mapping, data -> mappingSize);
+	}
+#endif
+
+	data -> mapping     = NULL;
+	data -> mappingSize = 0;
+}
+
 static BKInt BKDataPromoteToCopy (BKData * data)
 {
 	BKSize    size;
@@ -154,6 +174,8 @@ static BKInt BKDataPromoteToCopy (BKData * data)
 
 		data -> frames = frames;
 		data -> object.flags |= BK_DATA_FLAG_COPY;
+
+		BKDataUnmap (data);
 	}
 
 	return 0;
@@ -176,6 +198,8 @@ static void BKDataDisposeObject (BKData * data)
 	if (data -> frames && (data -> object.flags & BK_DATA_FLAG_COPY)) {
 		free (data -> frames);
 	}
+
+	BKDataUnmap (data);
 }
 
 void BKDataDetach (BKData * data)
@@ -193,8 +217,10 @@ BKInt BKDataInitCopy (BKData * copy, BKData const * original)
 	memcpy (copy, original, sizeof (BKData));
 
 	copy -> object.flags &= BK_DATA_FLAG_COPY_MASK;
-	copy -> stateList = NULL;
-	copy -> frames    = NULL;
+	copy -> stateList   = NULL;
+	copy -> frames      = NULL;
+	copy -> mapping     = NULL;
+	copy -> mappingSize = 0;
 
 	if (original -> frames)
 		res = BKDataSetFrames (copy, original -> frames, original -> numFrames, original -> numChannels, 1);
@@ -373,6 +399,9 @@ BKInt BKDataSetFrames (BKData * data, BKFrame const * frames, BKUInt numFrames,
 		return -1;
 	}
 
+	// copied frames may have been read from the mapping
+	BKDataUnmap (data);
+
 	data -> frames      = newFrames;
 	data -> numFrames   = numFrames;
 	data -> numChannels = numChannels;
@@ -576,6 +605,10 @@ BKInt BKDataSetData (BKData * data, void const * frameData, BKUInt dataSize, BKU
 	if (BKDataConvertFromBits (frames, frameData, dataSize, numBits, isSigned, reverseEndian, numChannels) < 0)
 		return -1;
 
+	// frame data may have been read from the mapping
+	BKDataUnmap (data);
+
+	data -> object.flags |= BK_DATA_FLAG_COPY;
 	data -> frames      = frames;
 	data -> numFrames   = numFrames / numChannels;
 	data -> numChannels = numChannels;
@@ -660,6 +693,218 @@ BKInt BKDataLoadWAVE (BKData * data, FILE * file)
 	return 0;
 }
 
+BKInt BKDataCheckSize (BKSize size)
+{
+	// data size is passed as `BKUInt`
+	if (size < 0 || (uint64_t) size > (BKUInt) -1) {
+		return BK_INVALID_VALUE;
+	}
+
+	return 0;
+}
+
+#if BK_USE_MMAP
+
+/**
+ * Map file privately from `offset` to its end
+ * `outData` points to `offset` in the mapping and `outSize` is the number of
+ * bytes after it
+ */
+static BKInt BKDataMapFile (FILE * file, BKSize offset, void ** outMapping, BKSize * outMappingSize, void ** outData, BKSize * outSize)
+{
+	struct stat info;
+	BKSize      pageOffset, mappingSize;
+	void      * mapping;
+
+	if (fstat (fileno (file), & info) < 0) {
+		return BK_FILE_ERROR;
+	}
+
+	if (offset >= info.st_size) {
+		return BK_INVALID_NUM_FRAMES;
+	}
+
+	// mapping has to begin at a page boundary
+	pageOffset  = offset % sysconf (_SC_PAGESIZE);
+	mappingSize = info.st_size - offset + pageOffset;
+
+	// frames are written only when reversing their endianness
+	mapping = mmap (NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno (file), offset - pageOffset);
+
+	if (mapping == MAP_FAILED) {
+		return BK_FILE_ERROR;
+	}
+
+	* outMapping     = mapping;
+	* outMappingSize = mappingSize;
+	* outData        = (char *) mapping + pageOffset;
+	* outSize        = info.st_size - offset;
+
+	return 0;
+}
+
+/**
+ * Reverse endianness of 16 bit frames
+ */
+static void BKDataReverseFrames (BKFrame * frames, BKSize length)
+{
+	uint16_t frame;
+
+	for (BKSize i = 0; i < length; i ++) {
+		frame = (uint16_t) frames [i];
+		frames [i] = (BKFrame) ((frame << 8) | (frame >> 8));
+	}
+}
+
+/**
+ * Replace frames with frames pointing into `mapping`
+ */
+static BKInt BKDataSetMapping (BKData * data, void * mapping, BKSize mappingSize, BKFrame * frames, BKUInt numFrames, BKUInt numChannels)
+{
+	// need at least 2 phases
+	if (numFrames < 2) {
+		munmap (mapping, mappingSize);
+		return BK_INVALID_NUM_FRAMES;
+	}
+
+	if (data -> frames && (data -> object.flags & BK_DATA_FLAG_COPY)) {
+		free (data -> frames);
+	}
+
+	BKDataUnmap (data);
+
+	data -> object.flags &= ~BK_DATA_FLAG_COPY;
+	data -> mapping       = mapping;
+	data -> mappingSize   = mappingSize;
+	data -> frames        = frames;
+	data -> numFrames     = numFrames;
+	data -> numChannels   = numChannels;
+	data -> numBits       = 16;
+
+	BKDataResetStates (data, BK_DATA_STATE_EVENT_RESET);
+
+	return 0;
+}
+
+BKInt BKDataLoadRawMapped (BKData * data, FILE * file, BKUInt numChannels, BKEnum params)
+{
+	BKUInt  endian = (params & BK_ENDIAN_MASK);
+	BKInt   reverseEndian = 0;
+	BKInt   res;
+	BKSize  offset, size, mappingSize;
+	void  * mapping;
+	void  * frameData;
+
+	if (numChannels < 1 || numChannels > BK_MAX_CHANNELS) {
+		return BK_INVALID_NUM_CHANNELS;
+	}
+
+	offset = ftell (file);
+
+	if (offset < 0) {
+		return BK_FILE_ERROR;
+	}
+
+	if ((res = BKDataMapFile (file, offset, & mapping, & mappingSize, & frameData, & size)) != 0) {
+		return res;
+	}
+
+	if ((res = BKDataCheckSize (size)) != 0) {
+		munmap (mapping, mappingSize);
+		return res;
+	}
+
+	// convert other formats and unaligned frames into a copy
+	if ((params & BK_DATA_BITS_MASK) != BK_16_BIT_SIGNED || (offset & 1)) {
+		res = BKDataSetData (data, frameData, (BKUInt) size, numChannels, params);
+		munmap (mapping, mappingSize);
+
+		return res;
+	}
+
+	if (endian) {
+		reverseEndian = BKSystemIsBigEndian () != (endian == BK_BIG_ENDIAN);
+	}
+
+	size /= sizeof (BKFrame) * numChannels;
+
+	if (reverseEndian) {
+		BKDataReverseFrames (frameData, size * numChannels);
+	}
+
+	return BKDataSetMapping (data, mapping, mappingSize, frameData, (BKUInt) size, numChannels);
+}
+
+BKInt BKDataLoadWAVEMapped (BKData * data, FILE * file)
+{
+	BKWaveFileReader reader;
+	BKInt  numChannels, sampleRate, numFrames, numBits;
+	BKInt  res;
+	BKSize start, offset, size, mappingSize;
+	void * mapping;
+	void * frameData;
+
+	start = ftell (file);
+
+	if (start < 0) {
+		return BK_FILE_ERROR;
+	}
+
+	if (BKWaveFileReaderInit (& reader, file) < 0) {
+		return BK_INVALID_RETURN_VALUE;
+	}
+
+	if (BKWaveFileReaderReadHeader (& reader, & numChannels, & sampleRate, & numFrames) < 0) {
+		return BK_INVALID_RETURN_VALUE;
+	}
+
+	numBits = reader.numBits;
+	offset  = ftell (file);
+
+	BKDispose (& reader);
+
+	// read 8 bit frames and unaligned frames into a copy
+	if (numBits != 16 || (offset & 1)) {
+		fseek (file, start, SEEK_SET);
+
+		return BKDataLoadWAVE (data, file);
+	}
+
+	if ((res = BKDataMapFile (file, offset, & mapping, & mappingSize, & frameData, & size)) != 0) {
+		return res;
+	}
+
+	// file may be truncated
+	numFrames = (BKInt) BKMin ((BKSize) numFrames, size / (sizeof (BKFrame) * numChannels));
+
+	// WAVE frames are little endian
+	if (BKSystemIsBigEndian ()) {
+		BKDataReverseFrames (frameData, numFrames * numChannels);
+	}
+
+	if ((res = BKDataSetMapping (data, mapping, mappingSize, frameData, numFrames, numChannels)) != 0) {
+		return res;
+	}
+
+	data -> sampleRate = sampleRate;
+
+	return 0;
+}
+
+#else /* ! BK_USE_MMAP */
+
+BKInt BKDataLoadRawMapped (BKData * data, FILE * file, BKUInt numChannels, BKEnum params)
+{
+	return BKDataLoadRaw (data, file, numChannels, params);
+}
+
+BKInt BKDataLoadWAVEMapped (BKData * data, FILE * file)
+{
+	return BKDataLoadWAVE (data, file);
+}
+
+#endif /* BK_USE_MMAP */
+
 BKInt BKDataNormalize (BKData * data)
 {
 	BKInt res = 0;
@@ -808,6 +1053,9 @@ BKInt BKDataConvert (BKData * data, BKDataConvertInfo * info)
 
 	BKDataReduceBits (convertedFrames, data -> frames, length, & validatedInfo);
 
+	BKDataUnmap (data);
+
+	data -> object.flags |= BK_DATA_FLAG_COPY;
 	data -> frames = convertedFrames;
 
 	BKDataResetStates (data, BK_DATA_STATE_EVENT_RESET);
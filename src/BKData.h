@@ -81,6 +81,8 @@ struct BKData
 	BKUInt        sustainEnd;
 	BKFrame     * frames;
 	BKDataState * stateList;
+	void        * mapping;     // file mapping `frames` point into if loaded mapped
+	BKSize        mappingSize;
 };
 
 struct BKDataState
@@ -178,6 +180,33 @@ extern BKInt BKDataLoadRaw (BKData * data, FILE * file, BKUInt numChannels, BKEn
  */
 extern BKInt BKDataLoadWAVE (BKData * data, FILE * file);
 
+/**
+ * Load frames from raw audio file by mapping it into memory
+ * Frames with 16 bits point directly into the private mapping and are
+ * reversed in place if not in native endianness. Other formats are converted
+ * with `BKDataSetData`
+ * The mapping is removed when the frames are replaced or the data is disposed
+ * Same as `BKDataLoadRaw` if files cannot be mapped on this system
+ *
+ * Errors:
+ * BK_FILE_ERROR if the file could not be mapped
+ * BK_INVALID_VALUE if the file has 4 GiB or more after the current position
+ */
+extern BKInt BKDataLoadRawMapped (BKData * data, FILE * file, BKUInt numChannels, BKEnum params);
+
+/**
+ * Load frames from WAVE audio file by mapping it into memory
+ * 16 bit PCM frames point directly into the private mapping; 8 bit frames are
+ * read with `BKDataLoadWAVE`
+ * The mapping is removed when the frames are replaced or the data is disposed
+ * Same as `BKDataLoadWAVE` if files cannot be mapped on this system
+ * File `file` is not closed
+ *
+ * Errors:
+ * BK_FILE_ERROR if the file could not be mapped
+ */
+extern BKInt BKDataLoadWAVEMapped (BKData * data, FILE * file);
+
 /**
  * Normalize frames to maximum possible values
  * If BKData was initialized without copying frames, a copy is made
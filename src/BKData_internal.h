@@ -30,4 +30,12 @@
  */
 extern BKInt BKDataStateSetData (BKDataState * state, BKData * data);
 
+/**
+ * Check if `size` bytes of frames can be passed as data size
+ *
+ * Errors:
+ * BK_INVALID_VALUE if `size` is negative or does not fit into `BKUInt`
+ */
+extern BKInt BKDataCheckSize (BKSize size);
+
 #endif /* ! _BK_DATA_INTERN_H_ */
@@ -162,8 +162,10 @@ static void BKInstrumentStateSetSequence (BKInstrument * instr, BKEnum slot, BKS
 {
 	instr -> sequences [slot] = sequence;
 
-	for (BKInstrumentState * state = instr -> stateList; state; state = state -> nextState)
+	for (BKInstrumentState * state = instr -> stateList; state; state = state -> nextState) {
 		state -> states [slot].sequence = sequence;
+		state -> states [slot].index    = -1;
+	}
 }
 
 static BKInt BKInstrumentSetSequenceValues (BKInstrument * instr, BKSequenceFuncs const * funcs, BKEnum slot, void const * values, BKUInt length, BKInt sustainOffset, BKInt sustainLength)
@@ -283,8 +285,10 @@ BKInt BKInstrumentStateSetInstrument (BKInstrumentState * state, BKInstrument *
 	BKInstrumentStateAddToInstrument (state, instr);
 
 	if (instr) {
-		for (BKInt i = 0; i < BK_MAX_SEQUENCES; i ++)
+		for (BKInt i = 0; i < BK_MAX_SEQUENCES; i ++) {
 			state -> states [i].sequence = state -> instrument -> sequences [i];
+			state -> states [i].index    = -1;
+		}
 
 		BKInstrumentStateSetDefaultValues (state);
 		BKInstrumentStateSetPhase (state, BK_SEQUENCE_PHASE_ATTACK);
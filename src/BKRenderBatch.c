@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2012-2016 Simon Schoenenberger
+ * http://blipkit.audio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <time.h>
+#include "BKContext_internal.h"
+#include "BKRenderBatch.h"
+
+#define BK_RENDER_RANGE(low, high) (((uint64_t) (high) << 32) | (low))
+#define BK_RENDER_RANGE_LOW(range) ((BKUInt) (range))
+#define BK_RENDER_RANGE_HIGH(range) ((BKUInt) ((range) >> 32))
+
+static double BKRenderBatchGetTime (void)
+{
+	struct timespec time;
+
+	timespec_get (& time, TIME_UTC);
+
+	return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+BKInt BKRenderBatchInit (BKRenderBatch * batch, BKUInt numThreads)
+{
+	BKInt res;
+	BKRenderThread * thread;
+
+	memset (batch, 0, sizeof (BKRenderBatch));
+
+	if ((res = BKWorkersInit (& batch -> workers, numThreads)) != 0) {
+		return res;
+	}
+
+	batch -> threads = calloc (numThreads, sizeof (BKRenderThread));
+
+	if (batch -> threads == NULL) {
+		BKRenderBatchDispose (batch);
+		return BK_ALLOCATION_ERROR;
+	}
+
+	for (BKUInt i = 0; i < numThreads; i ++) {
+		thread = & batch -> threads [i];
+		thread -> batch  = batch;
+		thread -> frames = malloc (BK_MAX_CHANNELS * BK_MAX_GENERATE_SAMPLES * sizeof (BKFrame));
+
+		if (thread -> frames == NULL) {
+			BKRenderBatchDispose (batch);
+			return BK_ALLOCATION_ERROR;
+		}
+	}
+
+	return 0;
+}
+
+void BKRenderBatchDispose (BKRenderBatch * batch)
+{
+	if (batch -> threads) {
+		for (BKUInt i = 0; i < batch -> workers.numThreads; i ++)
+			free (batch -> threads [i].frames);
+
+		free (batch -> threads);
+	}
+
+	BKWorkersDispose (& batch -> workers);
+	memset (batch, 0, sizeof (BKRenderBatch));
+}
+
+/**
+ * Take job from the beginning of the range of `thread`
+ * If `steal` is set, the job is taken from the end
+ */
+static BKRenderJob * BKRenderThreadTakeJob (BKRenderThread * thread, BKInt steal)
+{
+	uint64_t range, newRange;
+	BKUInt   low, high, index;
+
+	range = __atomic_load_n (& thread -> range, __ATOMIC_ACQUIRE);
+
+	do {
+		low  = BK_RENDER_RANGE_LOW (range);
+		high = BK_RENDER_RANGE_HIGH (range);
+
+		if (low >= high) {
+			return NULL;
+		}
+
+		if (steal) {
+			index    = high - 1;
+			newRange = BK_RENDER_RANGE (low, high - 1);
+		}
+		else {
+			index    = low;
+			newRange = BK_RENDER_RANGE (low + 1, high);
+		}
+	}
+	while (!__atomic_compare_exchange_n (& thread -> range, & range, newRange, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	return & thread -> batch -> jobs [index];
+}
+
+static BKInt BKRenderThreadWrite (BKFrame inFrames [], BKUInt size, BKRenderThread * thread)
+{
+	BKRenderJob   * job   = thread -> job;
+	BKRenderBatch * batch = thread -> batch;
+	BKInt           res;
+
+	res = job -> write (inFrames, size, job -> info);
+
+	// only this thread writes `numFrames`
+	__atomic_store_n (& job -> numFrames, job -> numFrames + size, __ATOMIC_RELAXED);
+
+	if (batch -> progress) {
+		batch -> progress (job, batch -> progressInfo);
+	}
+
+	return res;
+}
+
+static void BKRenderThreadRunJob (BKRenderThread * thread, BKRenderJob * job)
+{
+	double startTime = BKRenderBatchGetTime ();
+
+	thread -> job = job;
+	__atomic_store_n (& job -> state, BK_RENDER_JOB_RUNNING, __ATOMIC_RELAXED);
+
+	job -> result = BKContextGenerateToTimeFrames (job -> ctx, job -> endTime, thread -> frames,
+		(BKRenderWriteFunc) BKRenderThreadWrite, thread);
+	job -> seconds = BKRenderBatchGetTime () - startTime;
+
+	// publish `result` and `seconds`
+	__atomic_store_n (& job -> state, BK_RENDER_JOB_DONE, __ATOMIC_RELEASE);
+	thread -> job = NULL;
+}
+
+/**
+ * Run own jobs and then steal jobs from other threads
+ */
+static void BKRenderBatchRunThread (BKRenderBatch * batch, BKUInt index)
+{
+	BKUInt           numThreads = batch -> workers.numThreads;
+	BKRenderThread * thread = & batch -> threads [index];
+	BKRenderJob    * job;
+
+	for (;;) {
+		job = BKRenderThreadTakeJob (thread, 0);
+
+		for (BKUInt i = 1; job == NULL && i < numThreads; i ++)
+			job = BKRenderThreadTakeJob (& batch -> threads [(index + i) % numThreads], 1);
+
+		if (job == NULL)
+			break;
+
+		BKRenderThreadRunJob (thread, job);
+	}
+}
+
+BKInt BKRenderBatchRun (BKRenderBatch * batch, BKRenderJob jobs [], BKUInt numJobs, BKRenderProgressFunc progress, void * info)
+{
+	BKUInt numThreads = batch -> workers.numThreads;
+	BKInt  numErrors = 0;
+	double startTime;
+
+	batch -> jobs         = jobs;
+	batch -> numJobs      = numJobs;
+	batch -> progress     = progress;
+	batch -> progressInfo = info;
+
+	for (BKUInt i = 0; i < numJobs; i ++) {
+		jobs [i].state     = BK_RENDER_JOB_WAITING;
+		jobs [i].result    = 0;
+		jobs [i].numFrames = 0;
+		jobs [i].seconds   = 0.0;
+	}
+
+	// split jobs into equal ranges
+	for (BKUInt i = 0; i < numThreads; i ++) {
+		BKUInt low  = (uint64_t) numJobs * i / numThreads;
+		BKUInt high = (uint64_t) numJobs * (i + 1) / numThreads;
+
+		batch -> threads [i].range = BK_RENDER_RANGE (low, high);
+	}
+
+	startTime = BKRenderBatchGetTime ();
+
+	BKWorkersRun (& batch -> workers, (BKWorkersFunc) BKRenderBatchRunThread, batch);
+
+	batch -> seconds   = BKRenderBatchGetTime () - startTime;
+	batch -> numFrames = 0;
+
+	for (BKUInt i = 0; i < numJobs; i ++) {
+		batch -> numFrames += BKRenderJobGetNumFrames (& jobs [i]);
+
+		if (jobs [i].result < 0)
+			numErrors ++;
+	}
+
+	batch -> jobs    = NULL;
+	batch -> numJobs = 0;
+
+	return numErrors;
+}
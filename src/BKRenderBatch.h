@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2012-2016 Simon Schoenenberger
+ * http://blipkit.audio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * @file
+ * Renders many independent contexts in parallel
+ *
+ * Jobs are distributed over the threads of the batch. A thread which has
+ * finished its own jobs steals jobs from the other threads.
+ */
+
+#ifndef _BK_RENDER_BATCH_H_
+#define _BK_RENDER_BATCH_H_
+
+#include "BKContext.h"
+#include "BKWorkers.h"
+
+typedef struct BKRenderJob     BKRenderJob;
+typedef struct BKRenderBatch   BKRenderBatch;
+typedef struct BKRenderThread  BKRenderThread;
+
+/**
+ * Called with the rendered frames of a job
+ * Returning a value other than 0 aborts the job
+ */
+typedef BKInt (* BKRenderWriteFunc) (BKFrame inFrames [], BKUInt size, void * info);
+
+/**
+ * Called after each written chunk of `job`
+ * May be called from any thread of the batch
+ */
+typedef void (* BKRenderProgressFunc) (BKRenderJob const * job, void * info);
+
+enum
+{
+	BK_RENDER_JOB_WAITING,
+	BK_RENDER_JOB_RUNNING,
+	BK_RENDER_JOB_DONE,
+};
+
+/**
+ * A context rendered to `endTime`
+ * Each job must have its own context
+ *
+ * `state` and `numFrames` are written atomically by the rendering thread and
+ * should be read with `BKRenderJobGetState` and `BKRenderJobGetNumFrames`
+ * while the batch is running. `result` and `seconds` are set before `state`
+ * becomes `BK_RENDER_JOB_DONE`
+ */
+struct BKRenderJob
+{
+	BKContext       * ctx;
+	BKTime            endTime;
+	BKRenderWriteFunc write;
+	void            * info;
+
+	// set while rendering
+	BKEnum  state;
+	BKInt   result;    // number of frames or error
+	BKUInt  numFrames; // frames written so far
+	double  seconds;   // time spent rendering
+};
+
+/**
+ * Thread state with its own job range and frame buffer
+ */
+struct BKRenderThread
+{
+	uint64_t        range;  // `BKUInt` job indices from low (owner) to high (thieves)
+	BKRenderBatch * batch;
+	BKRenderJob   * job;
+	BKFrame       * frames;
+};
+
+struct BKRenderBatch
+{
+	BKWorkers            workers;
+	BKRenderThread     * threads;
+	BKRenderJob        * jobs;
+	BKUInt               numJobs;
+	BKRenderProgressFunc progress;
+	void               * progressInfo;
+
+	// throughput of last run
+	uint64_t numFrames;
+	double   seconds;
+};
+
+/**
+ * Initialize batch with `numThreads` threads
+ * `numThreads` may be between 1 and BK_MAX_THREADS
+ *
+ * Errors:
+ * BK_INVALID_VALUE if `numThreads` is invalid or threads are not supported
+ * BK_ALLOCATION_ERROR if memory or threads could not be allocated
+ */
+extern BKInt BKRenderBatchInit (BKRenderBatch * batch, BKUInt numThreads);
+
+/**
+ * Stop threads and dispose batch
+ */
+extern void BKRenderBatchDispose (BKRenderBatch * batch);
+
+/**
+ * Render `numJobs` `jobs` and return when all are done
+ * Each context is rendered like with `BKContextGenerateToTime`
+ * `progress` is optional
+ *
+ * Returns the number of failed jobs; the error of each job is set in its
+ * `result`
+ */
+extern BKInt BKRenderBatchRun (BKRenderBatch * batch, BKRenderJob jobs [], BKUInt numJobs, BKRenderProgressFunc progress, void * info);
+
+/**
+ * Get state of `job`
+ * May be called from any thread
+ */
+BK_INLINE BKEnum BKRenderJobGetState (BKRenderJob const * job);
+
+/**
+ * Get number of frames written by `job` so far
+ * May be called from any thread
+ */
+BK_INLINE BKUInt BKRenderJobGetNumFrames (BKRenderJob const * job);
+
+/**
+ * Get frames per second rendered by `job`
+ * Returns 0 if `job` is not done
+ */
+BK_INLINE double BKRenderJobGetThroughput (BKRenderJob const * job);
+
+/**
+ * Get frames per second rendered by all jobs of the last run
+ */
+BK_INLINE double BKRenderBatchGetThroughput (BKRenderBatch const * batch);
+
+
+BK_INLINE BKEnum BKRenderJobGetState (BKRenderJob const * job)
+{
+	return __atomic_load_n (& job -> state, __ATOMIC_ACQUIRE);
+}
+
+BK_INLINE BKUInt BKRenderJobGetNumFrames (BKRenderJob const * job)
+{
+	return __atomic_load_n (& job -> numFrames, __ATOMIC_RELAXED);
+}
+
+BK_INLINE double BKRenderJobGetThroughput (BKRenderJob const * job)
+{
+	if (BKRenderJobGetState (job) != BK_RENDER_JOB_DONE) {
+		return 0.0;
+	}
+
+	return job -> seconds > 0.0 ? job -> numFrames / job -> seconds : 0.0;
+}
+
+BK_INLINE double BKRenderBatchGetThroughput (BKRenderBatch const * batch)
+{
+	return batch -> seconds > 0.0 ? batch -> numFrames / batch -> seconds : 0.0;
+}
+
+#endif /* ! _BK_RENDER_BATCH_H_ */
@@ -196,39 +196,7 @@ static BKInt BKSequenceEnvelopeCheckValues (BKSequencePhase const * values, BKUI
 	return 0;
 }
 
-static BKInt BKSequenceFuncEnvelopeCreate (BKSequence ** outSequence, BKSequenceFuncs const * funcs, void const * values, BKUInt length, BKUInt sustainOffset, BKUInt sustainLength)
-{
-	sustainOffset = BKClamp (sustainOffset, 0, length);
-	sustainLength = BKClamp (sustainLength, 0, length - sustainOffset);
-
-	if (BKSequenceEnvelopeCheckValues (values, length, sustainOffset, sustainLength) != 0)
-		return BK_INVALID_VALUE;
-
-	BKInt        size     = sizeof (BKSequencePhase) * length;
-	BKSequence * sequence = malloc (sizeof (* sequence) + size);
-
-	if (sequence) {
-		memset (sequence, 0, sizeof ( * sequence));
-
-		sequence -> values = (void *) sequence + sizeof (* sequence);
-
-		memcpy (sequence -> values, values, size);
-
-		sequence -> funcs         = funcs;
-		sequence -> length        = length;
-		sequence -> sustainOffset = sustainOffset;
-		sequence -> sustainLength = sustainLength;
-		sequence -> fracShift     = BKSequencePhaseGetFracShift (values, length);
-
-		* outSequence = sequence;
-
-		return 0;
-	}
-
-	return BK_ALLOCATION_ERROR;
-}
-
-static BKEnum BKSequenceFuncEnvelopeStep (BKSequenceState * state, BKEnum level)
+static BKEnum BKSequenceEnvelopeInterpolate (BKSequenceState * state, BKEnum level)
 {
 	if (level < BK_SEQUENCE_STEP_MAX)
 		return BK_SEQUENCE_RETURN_NONE;
@@ -292,7 +260,7 @@ static BKEnum BKSequenceFuncEnvelopeStep (BKSequenceState * state, BKEnum level)
 	return result;
 }
 
-static BKInt BKSequenceFuncEnvelopeSetPhase (BKSequenceState * state, BKEnum phase)
+static BKInt BKSequenceEnvelopeSetPhase (BKSequenceState * state, BKEnum phase)
 {
 	BKInt        result   = BK_SEQUENCE_RETURN_NONE;
 	BKSequence * sequence = state -> sequence;
@@ -312,7 +280,7 @@ static BKInt BKSequenceFuncEnvelopeSetPhase (BKSequenceState * state, BKEnum pha
 			state -> offset = 0;
 			state -> phase  = BK_SEQUENCE_PHASE_ATTACK;
 
-			result = BKSequenceFuncEnvelopeStep (state, 0);  // make first step
+			result = BKSequenceEnvelopeInterpolate (state, 0);  // make first step
 
 			break;
 		}
@@ -321,7 +289,7 @@ static BKInt BKSequenceFuncEnvelopeSetPhase (BKSequenceState * state, BKEnum pha
 			state -> offset = sequence -> sustainOffset + sequence -> sustainLength;
 			state -> phase  = BK_SEQUENCE_PHASE_RELEASE;
 
-			result = BKSequenceFuncEnvelopeStep (state, 0);  // make first step
+			result = BKSequenceEnvelopeInterpolate (state, 0);  // make first step
 
 			break;
 		}
@@ -341,10 +309,282 @@ static BKInt BKSequenceFuncEnvelopeSetPhase (BKSequenceState * state, BKEnum pha
 	return result;
 }
 
+/**
+ * Record state of baked step at `index`
+ */
+static void BKSequenceEnvelopeRecord (BKSequence * sequence, BKSequenceState const * state, BKInt index)
+{
+	BKSequencePhase const * phases = sequence -> values;
+	BKSequenceStep        * step   = & sequence -> bakedSteps [index];
+
+	step -> shiftedValue = state -> shiftedValue;
+	step -> delta        = state -> delta;
+	step -> offset       = state -> offset;
+	step -> steps        = state -> steps;
+
+	// first step entering phase
+	if (state -> offset < sequence -> length && state -> steps == phases [state -> offset].steps) {
+		if (sequence -> phaseIndex [state -> offset] < 0)
+			sequence -> phaseIndex [state -> offset] = index;
+	}
+}
+
+/**
+ * Record steps until envelope does not advance anymore
+ * Stops at the second repetition of the sustain phases
+ */
+static BKInt BKSequenceEnvelopeRecordSteps (BKSequence * sequence, BKSequenceState * state, BKEnum result, BKInt index)
+{
+	while (result & BK_SEQUENCE_RETURN_ACTIVE_MASK) {
+		if (result & BK_SEQUENCE_RETURN_REPEAT) {
+			if (sequence -> loopIndex >= 0) {
+				sequence -> loopEnd = index;
+				return index;
+			}
+
+			sequence -> loopIndex = index;
+		}
+
+		BKSequenceEnvelopeRecord (sequence, state, index ++);
+		result = BKSequenceEnvelopeInterpolate (state, BK_SEQUENCE_STEP_MAX);
+	}
+
+	if (result & BK_SEQUENCE_RETURN_FINISH)
+		BKSequenceEnvelopeRecord (sequence, state, index ++);
+
+	return index;
+}
+
+/**
+ * Precompute the steps of attacking from value 0 and of releasing from the
+ * last sustain value
+ *
+ * States attacked or released from other values are interpolated until they
+ * enter a phase from which the steps are the same
+ */
+static BKInt BKSequenceEnvelopeBake (BKSequence * sequence)
+{
+	BKSequencePhase const * phases = sequence -> values;
+	BKSequenceState         state;
+	BKInt                   sustainEnd = sequence -> sustainOffset + sequence -> sustainLength;
+	BKInt                   size = 2;  // finishing steps
+	BKInt                   index = 0;
+	BKEnum                  result;
+
+	sequence -> loopIndex    = -1;
+	sequence -> loopEnd      = -1;
+	sequence -> releaseIndex = -1;
+
+	// steps of all phases and of repeated sustain phases
+	for (BKInt i = 0; i < sequence -> length; i ++) {
+		size += BKMin (phases [i].steps, BK_SEQUENCE_MAX_BAKED_STEPS);
+
+		if (i >= sequence -> sustainOffset && i < sustainEnd)
+			size += BKMin (phases [i].steps, BK_SEQUENCE_MAX_BAKED_STEPS);
+
+		// interpolate only
+		if (size > BK_SEQUENCE_MAX_BAKED_STEPS)
+			return 0;
+	}
+
+	sequence -> bakedSteps = malloc (size * sizeof (BKSequenceStep) + sequence -> length * sizeof (BKInt));
+
+	if (sequence -> bakedSteps == NULL)
+		return BK_ALLOCATION_ERROR;
+
+	sequence -> phaseIndex = (void *) & sequence -> bakedSteps [size];
+
+	for (BKInt i = 0; i < sequence -> length; i ++)
+		sequence -> phaseIndex [i] = -1;
+
+	memset (& state, 0, sizeof (state));
+	state.sequence = sequence;
+
+	result = BKSequenceEnvelopeSetPhase (& state, BK_SEQUENCE_PHASE_ATTACK);
+
+	if (result & BK_SEQUENCE_RETURN_ACTIVE_MASK)
+		index = BKSequenceEnvelopeRecordSteps (sequence, & state, result, index);
+
+	memset (& state, 0, sizeof (state));
+	state.sequence = sequence;
+
+	if (sustainEnd > 0)
+		state.shiftedValue = phases [sustainEnd - 1].value << sequence -> fracShift;
+
+	state.value = state.shiftedValue >> sequence -> fracShift;
+
+	result = BKSequenceEnvelopeSetPhase (& state, BK_SEQUENCE_PHASE_RELEASE);
+
+	if (result & BK_SEQUENCE_RETURN_ACTIVE_MASK) {
+		sequence -> releaseIndex = index;
+		index = BKSequenceEnvelopeRecordSteps (sequence, & state, result, index);
+	}
+
+	sequence -> numBakedSteps = index;
+
+	return 0;
+}
+
+static BKInt BKSequenceFuncEnvelopeCreate (BKSequence ** outSequence, BKSequenceFuncs const * funcs, void const * values, BKUInt length, BKUInt sustainOffset, BKUInt sustainLength)
+{
+	sustainOffset = BKClamp (sustainOffset, 0, length);
+	sustainLength = BKClamp (sustainLength, 0, length - sustainOffset);
+
+	if (BKSequenceEnvelopeCheckValues (values, length, sustainOffset, sustainLength) != 0)
+		return BK_INVALID_VALUE;
+
+	BKInt        size     = sizeof (BKSequencePhase) * length;
+	BKSequence * sequence = malloc (sizeof (* sequence) + size);
+
+	if (sequence) {
+		memset (sequence, 0, sizeof ( * sequence));
+
+		sequence -> values = (void *) sequence + sizeof (* sequence);
+
+		memcpy (sequence -> values, values, size);
+
+		sequence -> funcs         = funcs;
+		sequence -> length        = length;
+		sequence -> sustainOffset = sustainOffset;
+		sequence -> sustainLength = sustainLength;
+		sequence -> fracShift     = BKSequencePhaseGetFracShift (values, length);
+
+		if (BKSequenceEnvelopeBake (sequence) != 0) {
+			free (sequence);
+			return BK_ALLOCATION_ERROR;
+		}
+
+		* outSequence = sequence;
+
+		return 0;
+	}
+
+	return BK_ALLOCATION_ERROR;
+}
+
+/**
+ * Continue with baked steps from `index` if state is equal to that step
+ */
+static void BKSequenceEnvelopeSync (BKSequenceState * state, BKInt index)
+{
+	BKSequenceStep const * step;
+
+	if (index < 0 || index >= state -> sequence -> numBakedSteps)
+		return;
+
+	step = & state -> sequence -> bakedSteps [index];
+
+	if (step -> shiftedValue == state -> shiftedValue && step -> delta == state -> delta
+		&& step -> offset == state -> offset && step -> steps == state -> steps) {
+		state -> index = index;
+	}
+}
+
+/**
+ * Set interpolation state from baked step
+ */
+static void BKSequenceEnvelopeUnbake (BKSequenceState * state)
+{
+	BKSequence           * sequence = state -> sequence;
+	BKSequencePhase      * phases   = sequence -> values;
+	BKSequenceStep const * step;
+
+	if (state -> index < 0)
+		return;
+
+	step = & sequence -> bakedSteps [state -> index];
+
+	state -> shiftedValue = step -> shiftedValue;
+	state -> delta        = step -> delta;
+	state -> offset       = step -> offset;
+	state -> steps        = step -> steps;
+	state -> index        = -1;
+
+	if (step -> offset < sequence -> length)
+		state -> endValue = phases [step -> offset].value << sequence -> fracShift;
+}
+
+static BKEnum BKSequenceFuncEnvelopeStep (BKSequenceState * state, BKEnum level)
+{
+	BKEnum                 result;
+	BKInt                  index;
+	BKSequence           * sequence = state -> sequence;
+	BKSequenceStep const * step;
+
+	if (level < BK_SEQUENCE_STEP_MAX)
+		return BK_SEQUENCE_RETURN_NONE;
+
+	if (state -> index >= 0) {
+		result = BK_SEQUENCE_RETURN_STEP;
+		state -> index ++;
+
+		if (state -> index == sequence -> loopEnd)
+			state -> index = sequence -> loopIndex;
+
+		if (state -> index == sequence -> loopIndex)
+			result = BK_SEQUENCE_RETURN_REPEAT;
+
+		step = & sequence -> bakedSteps [state -> index];
+
+		state -> shiftedValue = step -> shiftedValue;
+		state -> value        = step -> shiftedValue >> sequence -> fracShift;
+
+		if (step -> offset == BK_INT_MAX) {
+			BKSequenceEnvelopeUnbake (state);
+			result = BK_SEQUENCE_RETURN_FINISH;
+		}
+
+		return result;
+	}
+
+	result = BKSequenceEnvelopeInterpolate (state, level);
+
+	// continue with baked steps after entering a phase
+	if (sequence -> bakedSteps && (result & BK_SEQUENCE_RETURN_ACTIVE_MASK)) {
+		if (result & BK_SEQUENCE_RETURN_REPEAT) {
+			index = sequence -> loopIndex;
+		}
+		else {
+			index = sequence -> phaseIndex [state -> offset];
+		}
+
+		BKSequenceEnvelopeSync (state, index);
+	}
+
+	return result;
+}
+
+static BKInt BKSequenceFuncEnvelopeSetPhase (BKSequenceState * state, BKEnum phase)
+{
+	BKInt        result;
+	BKSequence * sequence = state -> sequence;
+
+	state -> index = -1;
+
+	result = BKSequenceEnvelopeSetPhase (state, phase);
+
+	if (sequence -> bakedSteps && (result & BK_SEQUENCE_RETURN_ACTIVE_MASK)) {
+		switch (phase) {
+			case BK_SEQUENCE_PHASE_ATTACK: {
+				BKSequenceEnvelopeSync (state, 0);
+				break;
+			}
+			case BK_SEQUENCE_PHASE_RELEASE: {
+				BKSequenceEnvelopeSync (state, sequence -> releaseIndex);
+				break;
+			}
+		}
+	}
+
+	return result;
+}
+
 static BKInt BKSequenceFuncEnvelopeSetValue (BKSequenceState * state, BKInt value)
 {
 	BKSequence * sequence = state -> sequence;
 
+	BKSequenceEnvelopeUnbake (state);
+
 	state -> value        = value;
 	state -> shiftedValue = (value << sequence -> fracShift);
 
@@ -357,6 +597,7 @@ static BKInt BKSequenceFuncEnvelopeSetValue (BKSequenceState * state, BKInt valu
 static BKInt BKSequenceFuncEnvelopeCopy (BKSequence ** outCopy, BKSequence const * sequence)
 {
 	BKInt              size;
+	BKInt              bakedSize;
 	BKSequence       * copy;
 	BKSequencePhase  * values;
 
@@ -365,10 +606,24 @@ static BKInt BKSequenceFuncEnvelopeCopy (BKSequence ** outCopy, BKSequence const
 
 	if (copy) {
 		values = (void *) copy + sizeof (* copy);
-		copy -> values = values;
 
 		memcpy (copy, sequence, sizeof (* copy));
-		memcpy (copy -> values, sequence -> values, size);
+		memcpy (values, sequence -> values, size);
+
+		copy -> values = values;
+
+		if (sequence -> bakedSteps) {
+			bakedSize = (BKInt) ((char *) & sequence -> phaseIndex [sequence -> length] - (char *) sequence -> bakedSteps);
+			copy -> bakedSteps = malloc (bakedSize);
+
+			if (copy -> bakedSteps == NULL) {
+				free (copy);
+				return BK_ALLOCATION_ERROR;
+			}
+
+			memcpy (copy -> bakedSteps, sequence -> bakedSteps, bakedSize);
+			copy -> phaseIndex = (void *) ((char *) copy -> bakedSteps + ((char *) sequence -> phaseIndex - (char *) sequence -> bakedSteps));
+		}
 
 		* outCopy = copy;
 
@@ -453,6 +708,9 @@ BKInt BKSequenceCopy (BKSequence ** outSequence, BKSequence * sequence)
 
 void BKSequenceDispose (BKSequence * sequence)
 {
+	if (sequence)
+		free (sequence -> bakedSteps);
+
 	free (sequence);
 }
 
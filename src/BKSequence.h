@@ -26,10 +26,13 @@
 
 #include "BKBase.h"
 
+#define BK_SEQUENCE_MAX_BAKED_STEPS 4096
+
 typedef struct BKSequence      BKSequence;
 typedef struct BKSequenceState BKSequenceState;
 typedef struct BKSequenceFuncs BKSequenceFuncs;
 typedef struct BKSequencePhase BKSequencePhase;
+typedef struct BKSequenceStep  BKSequenceStep;
 
 /**
  * Sequence phases
@@ -111,6 +114,19 @@ struct BKSequencePhase
 	BKInt  value;
 };
 
+/**
+ * State of an envelope after a step
+ * Envelopes are stepped through precomputed steps as long as the state
+ * matches them
+ */
+struct BKSequenceStep
+{
+	BKInt shiftedValue;
+	BKInt delta;
+	BKInt offset; // BK_INT_MAX if envelope has finished
+	BKInt steps;
+};
+
 /**
  * Defines a sequence
  * This can be a simple array of values or an envelope
@@ -126,6 +142,14 @@ struct BKSequence
 	//BKInt                   defaultValue;
 	BKEnum                  state;
 	void                  * values;
+
+	// baked envelope steps or NULL
+	BKSequenceStep        * bakedSteps;
+	BKInt                 * phaseIndex;   // index of baked step entering phase
+	BKInt                   numBakedSteps;
+	BKInt                   loopIndex;    // index of step repeating sustain phases
+	BKInt                   loopEnd;
+	BKInt                   releaseIndex; // index of first release step
 };
 
 /**
@@ -143,6 +167,7 @@ struct BKSequenceState
 	BKInt             value;
 	BKInt             shiftedValue;
 	BKInt             endValue;
+	BKInt             index; // index of baked step or -1
 };
 
 /**
@@ -38,7 +38,7 @@
 
 BK_INLINE BKTime BKTimeMake (BKInt samples, BKFUInt20 frac)
 {
-	return (samples << BK_FINT20_SHIFT) + frac;
+	return ((BKTime) samples << BK_FINT20_SHIFT) + frac;
 }
 
 BK_INLINE BKInt BKTimeGetTime (BKTime a)
@@ -81,6 +81,16 @@ BKFUInt20 BKTonePeriodLookup (BKFInt20 tone, BKUInt sampleRate)
 	return period;
 }
 
+void BKTonePeriodTableInit (BKFUInt20 outPeriods [], BKUInt sampleRate)
+{
+	BKFInt20 tone;
+
+	for (BKInt i = 0; i < BK_TONE_TABLE_SIZE; i ++) {
+		tone = (BK_MIN_NOTE << BK_FINT20_SHIFT) + (i << (BK_FINT20_SHIFT - BK_TONE_TABLE_SHIFT));
+		outPeriods [i] = BKTonePeriodLookup (tone, sampleRate);
+	}
+}
+
 BKFUInt20 BKLog2PeriodLookup (BKFInt20 tone)
 {
 	BKUInt    frac;
@@ -50,6 +50,9 @@
 
 #define BK_TONE_SAMPLE_RATE_SHIFT 18 ///< Bit shift used for calculating sample pitch.
 
+#define BK_TONE_TABLE_SHIFT 6 ///< Note fraction bits of period tables (1/64 semitone).
+#define BK_TONE_TABLE_SIZE (((BK_MAX_NOTE - BK_MIN_NOTE) << BK_TONE_TABLE_SHIFT) + 1) ///< Number of entries of period tables.
+
 /**
  * Defines named notes.
  */
@@ -79,6 +82,12 @@ enum
  */
 extern BKFUInt20 BKTonePeriodLookup (BKFInt20 tone, BKUInt sampleRate);
 
+/**
+ * Fill `outPeriods` with `BK_TONE_TABLE_SIZE` periods of notes from
+ * `BK_MIN_NOTE` to `BK_MAX_NOTE` in steps of 1/64 semitone.
+ */
+extern void BKTonePeriodTableInit (BKFUInt20 outPeriods [], BKUInt sampleRate);
+
 /**
  * Calculate log2 of a note used for sample pitches.
  */
@@ -26,9 +26,57 @@
 #include "BKContext_internal.h"
 #include "BKUnit_internal.h"
 #include "BKInstrument_internal.h"
+#include "BKTrack_internal.h"
 
 #define BK_TRACK_EFFECT_MAX_STEPS (1 << 16)
 
+typedef struct BKTrackState         BKTrackState;
+typedef struct BKTrackSequenceState BKTrackSequenceState;
+
+/**
+ * Run state of instrument sequence
+ */
+struct BKTrackSequenceState
+{
+	BKEnum phase;
+	BKInt  steps;
+	BKInt  delta;
+	BKInt  offset;
+	BKInt  value;
+	BKInt  shiftedValue;
+	BKInt  endValue;
+	BKInt  index;
+};
+
+/**
+ * Run state of track following the unit state
+ */
+struct BKTrackState
+{
+	BKUInt               flags;
+	BKDividerState       arpeggioDivider;
+	BKDividerState       instrDivider;
+	BKDividerState       effectDivider;
+	BKInt                dutyCycle;
+	BKFInt20             samplePitch;
+	BKInt                masterVolume;
+	BKSlideState         volume;
+	BKSlideState         panning;
+	BKInt                curNote;
+	BKSlideState         note;
+	BKFInt20             pitch;
+	BKIntervalState      tremolo;
+	BKSlideState         tremoloDelta;
+	BKSlideState         tremoloSteps;
+	BKIntervalState      vibrato;
+	BKSlideState         vibratoDelta;
+	BKSlideState         vibratoSteps;
+	BKArpeggioState      arpeggio;
+	BKUInt               instrPhase;
+	BKInt                numActiveSequences;
+	BKTrackSequenceState sequences [BK_MAX_SEQUENCES];
+};
+
 extern BKClass BKTrackClass;
 
 extern BKInt const sequenceDefaultValue [BK_MAX_SEQUENCES];
@@ -37,10 +85,31 @@ void BKTrackReset (BKTrack * track);
 
 static void BKTrackUpdateUnit (BKTrack * track);
 static BKInt BKTrackRun (BKTrack * track, BKFUInt20 endTime);
+static BKSize BKTrackCopyState (BKTrack * track, void * state, BKInt restore);
 static void BKTrackSetNote (BKTrack * track, BKInt note);
 static void BKTrackSetInstrument (BKTrack * track, BKInstrument * instrument);
 static void BKTrackInstrumentUpdateFlags (BKTrack * track, BKInt all);
 
+/**
+ * Offsets of the track states stepped by `BKTrackTicker`
+ */
+static size_t const tickerSlideOffsets [BK_TRACK_TICKER_NUM_SLIDES] =
+{
+	[BKTrackTickerSlideNote]         = offsetof (BKTrack, note),
+	[BKTrackTickerSlideVolume]       = offsetof (BKTrack, volume),
+	[BKTrackTickerSlidePanning]      = offsetof (BKTrack, panning),
+	[BKTrackTickerSlideTremoloDelta] = offsetof (BKTrack, tremoloDelta),
+	[BKTrackTickerSlideTremoloSteps] = offsetof (BKTrack, tremoloSteps),
+	[BKTrackTickerSlideVibratoDelta] = offsetof (BKTrack, vibratoDelta),
+	[BKTrackTickerSlideVibratoSteps] = offsetof (BKTrack, vibratoSteps),
+};
+
+static size_t const tickerIntervalOffsets [BK_TRACK_TICKER_NUM_INTERVALS] =
+{
+	[BKTrackTickerIntervalTremolo] = offsetof (BKTrack, tremolo),
+	[BKTrackTickerIntervalVibrato] = offsetof (BKTrack, vibrato),
+};
+
 static BKInt BKTrackInstrStateCallback (BKEnum event, BKTrack * track)
 {
 	switch (event) {
@@ -80,9 +149,19 @@ static BKInt BKDividerStateTick (BKDividerState * dividerState)
 	return tick;
 }
 
+/**
+ * Set volume gains of the first two channels for `panning`
+ */
+static void BKTrackUpdatePanGains (BKTrack * track, BKInt panning)
+{
+	track -> panGains [0] = panning > 0 ? BK_MAX_VOLUME - panning : 1 << BK_VOLUME_SHIFT;
+	track -> panGains [1] = panning < 0 ? BK_MAX_VOLUME + panning : 1 << BK_VOLUME_SHIFT;
+	track -> gainsPanning = panning;
+}
+
 static void BKTrackUpdateUnitVolume (BKTrack * track)
 {
-	BKInt volume, volume0, volume1;
+	BKInt volume;
 	BKInt panning;
 	BKInt tremolo;
 	BKInt value;
@@ -116,17 +195,18 @@ static void BKTrackUpdateUnitVolume (BKTrack * track)
 	volume = BKClamp (volume, 0, BK_MAX_VOLUME);
 	volume = (volume * track -> masterVolume) >> BK_VOLUME_SHIFT;
 
-	if (panning && (track -> flags & BKPanningEnabledFlag)) {
+	if (track -> flags & BKPanningEnabledFlag) {
 		panning = BKClamp (panning, -BK_MAX_VOLUME, +BK_MAX_VOLUME);
-		volume0 = panning > 0 ? (((BK_MAX_VOLUME - panning) * volume) >> BK_VOLUME_SHIFT) : volume;
-		volume1 = panning < 0 ? (((BK_MAX_VOLUME + panning) * volume) >> BK_VOLUME_SHIFT) : volume;
-
-		BKUnitSetAttr (& track -> unit, BK_VOLUME_0, volume0);
-		BKUnitSetAttr (& track -> unit, BK_VOLUME_1, volume1);
 	}
 	else {
-		BKUnitSetAttr (& track -> unit, BK_VOLUME, volume);
+		panning = 0;
+	}
+
+	if (panning != track -> gainsPanning) {
+		BKTrackUpdatePanGains (track, panning);
 	}
+
+	BKUnitSetVolumes (& track -> unit, volume, track -> panGains);
 }
 
 static void BKTrackUpdateUnitNote (BKTrack * track)
@@ -151,14 +231,14 @@ static void BKTrackUpdateUnitNote (BKTrack * track)
 	note += track -> pitch;
 
 	if (track -> waveform != BK_SAMPLE) {
-		period = BKTonePeriodLookup (note, track -> unit.ctx -> sampleRate);
-		period /= track -> unit.phase.count;
-		BKUnitSetAttr (& track -> unit, BK_PERIOD, period);
+		period = BKContextTonePeriod (track -> unit.ctx, note);
+		period /= track -> unit.state -> phase.count;
+		BKUnitSetPeriod (& track -> unit, period);
 	}
 	else {
 		note += track -> samplePitch;
 		period = BKLog2PeriodLookup (note);
-		BKUnitSetAttr (& track -> unit, BK_SAMPLE_PERIOD, period);
+		BKUnitSetSamplePeriod (& track -> unit, period);
 	}
 }
 
@@ -171,7 +251,7 @@ static void BKTrackUpdateUnitDutyCycle (BKTrack * track)
 			dutyCycle = track -> instrState.states[BK_SEQUENCE_DUTY_CYCLE].value;
 	}
 
-	BKUnitSetAttr (& track -> unit, BK_DUTY_CYCLE, dutyCycle);
+	BKUnitSetDutyCycle (& track -> unit, dutyCycle);
 }
 
 static void BKTrackUpdateUnit (BKTrack * track)
@@ -266,75 +346,367 @@ static void BKTrackInstrumentUpdateFlags (BKTrack * track, BKInt all)
 	}
 }
 
+/**
+ * Make slide step and set `updateFlag` if the value has changed
+ * The unit is updated on the next tick
+ */
+static void BKTrackSlideTick (BKTrack * track, BKSlideState * slide, BKUInt updateFlag)
+{
+	BKInt value = BKSlideStateGetValue (slide);
+
+	BKSlideStateStep (slide);
+
+	if (BKSlideStateGetValue (slide) != value) {
+		track -> flags |= updateFlag;
+	}
+}
+
+/**
+ * Make interval step while sliding its delta and steps and set `updateFlag`
+ * if the value has changed
+ */
+static void BKTrackIntervalTick (BKTrack * track, BKIntervalState * interval, BKSlideState * delta, BKSlideState * steps, BKUInt updateFlag)
+{
+	BKInt value = BKIntervalStateGetValue (interval);
+
+	if (delta -> steps) {
+		BKSlideStateStep (delta);
+		BKSlideStateStep (steps);
+
+		BKIntervalStateSetDeltaAndSteps (
+			interval,
+			BKSlideStateGetValue (delta),
+			BKSlideStateGetValue (steps)
+		);
+	}
+
+	BKIntervalStateStep (interval);
+
+	if (BKIntervalStateGetValue (interval) != value) {
+		track -> flags |= updateFlag;
+	}
+}
+
+/**
+ * Step effects
+ */
 static void BKTrackEffectTick (BKTrack * track)
 {
 	if (track -> flags & BKPortamentoFlag) {
-		BKSlideStateStep (& track -> note);
+		BKTrackSlideTick (track, & track -> note, BKTrackEffectUpdateFlagNote);
 	}
 
 	if (track -> flags & BKVolumeSlideFlag) {
-		BKSlideStateStep (& track -> volume);
+		BKTrackSlideTick (track, & track -> volume, BKTrackEffectUpdateFlagVolume);
 	}
 
 	if (track -> flags & BKPanningSlideFlag) {
-		BKSlideStateStep (& track -> panning);
+		BKTrackSlideTick (track, & track -> panning, BKTrackEffectUpdateFlagVolume);
 	}
 
 	if (track -> flags & BKTremoloFlag) {
-		if (track -> tremoloDelta.steps) {
-			BKSlideStateStep (& track -> tremoloDelta);
-			BKSlideStateStep (& track -> tremoloSteps);
+		BKTrackIntervalTick (track, & track -> tremolo, & track -> tremoloDelta,
+			& track -> tremoloSteps, BKTrackEffectUpdateFlagVolume);
+	}
 
-			BKIntervalStateSetDeltaAndSteps (
-				& track -> tremolo,
-				BKSlideStateGetValue (& track -> tremoloDelta),
-				BKSlideStateGetValue (& track -> tremoloSteps)
-			);
+	if (track -> flags & BKVibratoFlag) {
+		BKTrackIntervalTick (track, & track -> vibrato, & track -> vibratoDelta,
+			& track -> vibratoSteps, BKTrackEffectUpdateFlagNote);
+	}
+}
+
+/**
+ * Update unit with effect values changed on the previous tick
+ */
+static void BKTrackEffectUpdateFlags (BKTrack * track)
+{
+	if (track -> flags & BKTrackEffectUpdateFlagVolume) {
+		track -> flags |= BKTrackAttrUpdateFlagVolume;
+	}
+
+	if (track -> flags & BKTrackEffectUpdateFlagNote) {
+		track -> flags |= BKTrackAttrUpdateFlagNote;
+	}
+
+	track -> flags &= ~(BKTrackEffectUpdateFlagVolume | BKTrackEffectUpdateFlagNote);
+}
+
+/**
+ * Check if track is silent and nothing has to be ticked
+ */
+static BKInt BKTrackIsIdle (BKTrack const * track)
+{
+	BKUnit const * unit = & track -> unit;
+
+	if (track -> flags & (BKArpeggioFlag | BKEffectMask)) {
+		return 0;
+	}
+
+	if (track -> flags & BKInstrumentFlag) {
+		if (track -> instrState.phase != BK_SEQUENCE_PHASE_MUTE || track -> instrState.numActiveSequences) {
+			return 0;
 		}
+	}
 
-		BKIntervalStateStep (& track -> tremolo);
+	if (unit -> mute) {
+		return 1;
 	}
 
-	if (track -> flags & BKVibratoFlag) {
-		if (track -> vibratoDelta.steps) {
-			BKSlideStateStep (& track -> vibratoDelta);
-			BKSlideStateStep (& track -> vibratoSteps);
+	// samples advance even without volume
+	if (unit -> waveform == BK_SAMPLE) {
+		return 0;
+	}
 
-			BKIntervalStateSetDeltaAndSteps (
-				& track -> vibrato,
-				BKSlideStateGetValue (& track -> vibratoDelta),
-				BKSlideStateGetValue (& track -> vibratoSteps)
-			);
+	for (BKInt i = 0; i < unit -> ctx -> numChannels; i ++) {
+		if (unit -> state -> volume [i]) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * Get states of track at `index` which change when stepped
+ */
+static BKUInt BKTrackTickerActiveStates (BKTrackTicker const * ticker, BKUInt index)
+{
+	BKUInt active = 0;
+
+	for (BKInt i = BKTrackTickerSlideNote; i <= BKTrackTickerSlidePanning; i ++) {
+		if (ticker -> slides [i][index].step > 0)
+			active |= 1 << i;
+	}
+
+	if (ticker -> slides [BKTrackTickerSlideTremoloDelta][index].steps)
+		active |= 1 << BKTrackTickerSlideTremoloDelta;
+
+	if (ticker -> slides [BKTrackTickerSlideVibratoDelta][index].steps)
+		active |= 1 << BKTrackTickerSlideVibratoDelta;
+
+	for (BKInt i = 0; i < BK_TRACK_TICKER_NUM_INTERVALS; i ++) {
+		if (ticker -> intervals [i][index].steps)
+			active |= 1 << (BK_TRACK_TICKER_NUM_SLIDES + i);
+	}
+
+	return active;
+}
+
+/**
+ * Load effect states of track into ticker
+ */
+static void BKTrackTickerLoad (BKTrackTicker * ticker, BKTrack * track)
+{
+	BKUInt index = track -> tickIndex;
+
+	for (BKInt i = 0; i < BK_TRACK_TICKER_NUM_SLIDES; i ++)
+		ticker -> slides [i][index] = * (BKSlideState *) ((char *) track + tickerSlideOffsets [i]);
+
+	for (BKInt i = 0; i < BK_TRACK_TICKER_NUM_INTERVALS; i ++)
+		ticker -> intervals [i][index] = * (BKIntervalState *) ((char *) track + tickerIntervalOffsets [i]);
+
+	ticker -> active [index] = BKTrackTickerActiveStates (ticker, index);
+
+	track -> flags &= ~BKTrackBatchLoadFlag;
+}
+
+/**
+ * Write effect states changed by the previous tick back into track
+ */
+static void BKTrackTickerStore (BKTrackTicker * ticker, BKTrack * track)
+{
+	BKUInt index   = track -> tickIndex;
+	BKUInt changes = ticker -> changes [index];
+
+	// intervals change on every step but slides only until they end
+	if (changes & ((1 << BK_TRACK_TICKER_NUM_SLIDES) - 1)) {
+		for (BKInt i = 0; i < BK_TRACK_TICKER_NUM_SLIDES; i ++) {
+			if (changes & (1 << i))
+				* (BKSlideState *) ((char *) track + tickerSlideOffsets [i]) = ticker -> slides [i][index];
 		}
+	}
 
-		BKIntervalStateStep (& track -> vibrato);
+	for (BKInt i = 0; i < BK_TRACK_TICKER_NUM_INTERVALS; i ++) {
+		if (changes & (1 << (BK_TRACK_TICKER_NUM_SLIDES + i)))
+			* (BKIntervalState *) ((char *) track + tickerIntervalOffsets [i]) = ticker -> intervals [i][index];
 	}
+
+	// unit is updated on the next tick
+	track -> flags |= ticker -> updates [index];
+
+	ticker -> changes [index] = 0;
+	ticker -> updates [index] = 0;
 }
 
-static void BKTrackEffectUpdateFlags (BKTrack * track)
+/**
+ * Write back effect states not yet written back by the next tick
+ * Has to be called before the states of a ticked track are accessed
+ */
+static void BKTrackTickerFlush (BKTrack * track)
 {
-	if (track -> flags & BKPortamentoFlag) {
-		track -> flags |= BKTrackAttrUpdateFlagNote;
+	BKTrackTicker * ticker;
+
+	if ((track -> flags & BKTrackBatchTickFlag) == 0 || (track -> unit.object.flags & BKUnitFlagSleeping)) {
+		return;
 	}
 
-	if (track -> flags & BKVolumeSlideFlag) {
-		track -> flags |= BKTrackAttrUpdateFlagVolume;
+	ticker = track -> unit.ctx -> ticker;
+
+	if (ticker -> changes [track -> tickIndex]) {
+		BKTrackTickerStore (ticker, track);
 	}
+}
 
-	if (track -> flags & BKPanningSlideFlag) {
-		track -> flags |= BKTrackAttrUpdateFlagVolume;
+static BKInt BKTrackTickerResize (void ** items, BKUInt capacity, size_t itemSize)
+{
+	void * newItems = realloc (* items, capacity * itemSize);
+
+	if (newItems == NULL) {
+		return BK_ALLOCATION_ERROR;
 	}
 
-	if (track -> flags & BKTremoloFlag) {
-		track -> flags |= BKTrackAttrUpdateFlagVolume;
+	* items = newItems;
+
+	return 0;
+}
+
+/**
+ * Reserve space for `capacity` tracks
+ * Arrays already resized keep their items if resizing another one fails
+ */
+static BKInt BKTrackTickerReserve (BKTrackTicker * ticker, BKUInt capacity)
+{
+	BKInt res = 0;
+
+	if (capacity <= ticker -> capacity) {
+		return 0;
 	}
 
-	if (track -> flags & BKVibratoFlag) {
-		track -> flags |= BKTrackAttrUpdateFlagNote;
+	capacity = BKMax (capacity, ticker -> capacity * 3 / 2);
+
+	res |= BKTrackTickerResize ((void **) & ticker -> tracks, capacity, sizeof (BKTrack *));
+	res |= BKTrackTickerResize ((void **) & ticker -> effects, capacity, sizeof (BKUInt));
+	res |= BKTrackTickerResize ((void **) & ticker -> active, capacity, sizeof (BKUInt));
+	res |= BKTrackTickerResize ((void **) & ticker -> changes, capacity, sizeof (BKUInt));
+	res |= BKTrackTickerResize ((void **) & ticker -> updates, capacity, sizeof (BKUInt));
+
+	for (BKInt i = 0; i < BK_TRACK_TICKER_NUM_SLIDES; i ++)
+		res |= BKTrackTickerResize ((void **) & ticker -> slides [i], capacity, sizeof (BKSlideState));
+
+	for (BKInt i = 0; i < BK_TRACK_TICKER_NUM_INTERVALS; i ++)
+		res |= BKTrackTickerResize ((void **) & ticker -> intervals [i], capacity, sizeof (BKIntervalState));
+
+	if (res != 0) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	ticker -> capacity = capacity;
+
+	return 0;
+}
+
+/**
+ * Append track to ticker and load its effect states
+ */
+static BKInt BKTrackTickerAdd (BKTrackTicker * ticker, BKTrack * track)
+{
+	BKUInt index = ticker -> numTracks;
+
+	if (BKTrackTickerReserve (ticker, index + 1) != 0) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	ticker -> tracks [index]  = track;
+	ticker -> effects [index] = 0;
+	ticker -> changes [index] = 0;
+	ticker -> updates [index] = 0;
+	ticker -> numTracks ++;
+
+	track -> tickIndex = index;
+
+	BKTrackTickerLoad (ticker, track);
+
+	return 0;
+}
+
+/**
+ * Remove track from ticker and write back its effect states
+ */
+static void BKTrackTickerRemove (BKTrackTicker * ticker, BKTrack * track)
+{
+	BKUInt index = track -> tickIndex;
+	BKUInt last  = -- ticker -> numTracks;
+
+	if (ticker -> changes [index]) {
+		BKTrackTickerStore (ticker, track);
+	}
+
+	// move last track to free index
+	ticker -> tracks [index]  = ticker -> tracks [last];
+	ticker -> effects [index] = ticker -> effects [last];
+	ticker -> active [index]  = ticker -> active [last];
+	ticker -> changes [index] = ticker -> changes [last];
+	ticker -> updates [index] = ticker -> updates [last];
+
+	for (BKInt i = 0; i < BK_TRACK_TICKER_NUM_SLIDES; i ++)
+		ticker -> slides [i][index] = ticker -> slides [i][last];
+
+	for (BKInt i = 0; i < BK_TRACK_TICKER_NUM_INTERVALS; i ++)
+		ticker -> intervals [i][index] = ticker -> intervals [i][last];
+
+	ticker -> tracks [index] -> tickIndex = index;
+}
+
+/**
+ * Stop ticking and running track until an attribute is set
+ * The divider stays attached to keep the order of ticks
+ */
+static void BKTrackSleep (BKTrack * track)
+{
+	BKUnitSleep (& track -> unit);
+
+	if ((track -> unit.object.flags & BKUnitFlagSleeping) == 0) {
+		return;
+	}
+
+	if (track -> flags & BKTrackBatchTickFlag) {
+		BKTrackTickerRemove (track -> unit.ctx -> ticker, track);
+	}
+	else {
+		track -> divider.callback.func = NULL;
 	}
 }
 
-static BKEnum BKTrackTick (BKCallbackInfo * info, BKTrack * track)
+static BKInt BKTrackWake (BKTrack * track)
+{
+	BKInt res;
+
+	if ((track -> unit.object.flags & BKUnitFlagSleeping) == 0) {
+		return 0;
+	}
+
+	if ((res = BKUnitWake (& track -> unit)) != 0) {
+		return res;
+	}
+
+	if (track -> flags & BKTrackBatchTickFlag) {
+		if ((res = BKTrackTickerAdd (track -> unit.ctx -> ticker, track)) != 0) {
+			BKUnitSleep (& track -> unit);
+			return res;
+		}
+	}
+	else {
+		track -> divider.callback.func = (BKCallbackFunc) BKTrackTick;
+	}
+
+	return 0;
+}
+
+/**
+ * Tick arpeggio and instrument and update unit
+ * Returns 1 if effects have to be stepped
+ */
+static BKInt BKTrackTickUnit (BKTrack * track)
 {
 	BKInt tick;
 
@@ -359,16 +731,235 @@ static BKEnum BKTrackTick (BKCallbackInfo * info, BKTrack * track)
 
 	BKTrackUpdateUnit (track);
 
-	// 4. Tick effects
+	// 4. Check if effects are stepped
 
 	if (track -> flags & BKEffectMask) {
-		if (BKDividerStateTick (& track -> effectDivider))
-			BKTrackEffectTick (track);
+		return BKDividerStateTick (& track -> effectDivider);
+	}
+
+	return 0;
+}
+
+BKEnum BKTrackTick (BKCallbackInfo * info, BKTrack * track)
+{
+	if (BKTrackTickUnit (track)) {
+		BKTrackEffectTick (track);
+	}
+
+	// 5. Sleep until woken by setting an attribute
+
+	if (BKTrackIsIdle (track)) {
+		BKTrackSleep (track);
+	}
+
+	return 0;
+}
+
+/**
+ * Step slide `slide` of all tracks stepping `effectFlag`
+ */
+static void BKTrackTickerStepSlides (BKTrackTicker * ticker, BKInt slide, BKUInt effectFlag, BKUInt updateFlag)
+{
+	BKSlideState * slides  = ticker -> slides [slide];
+	BKUInt const * effects = ticker -> effects;
+	BKUInt       * active  = ticker -> active;
+	BKUInt       * changes = ticker -> changes;
+	BKUInt       * updates = ticker -> updates;
+	BKUInt         bit     = 1 << slide;
+	BKInt          value;
+
+	for (BKUInt i = 0; i < ticker -> numTracks; i ++) {
+		// finished slides are not touched
+		if ((effects [i] & effectFlag) == 0 || (active [i] & bit) == 0) {
+			continue;
+		}
+
+		value = BKSlideStateGetValue (& slides [i]);
+		BKSlideStateStep (& slides [i]);
+		changes [i] |= bit;
+
+		if (slides [i].step <= 0) {
+			active [i] &= ~bit;
+		}
+
+		if (BKSlideStateGetValue (& slides [i]) != value) {
+			updates [i] |= updateFlag;
+		}
+	}
+}
+
+/**
+ * Step interval `interval` of all tracks stepping `effectFlag` while sliding
+ * its delta and steps
+ */
+static void BKTrackTickerStepIntervals (BKTrackTicker * ticker, BKInt interval, BKInt delta, BKInt steps, BKUInt effectFlag, BKUInt updateFlag)
+{
+	BKIntervalState * intervals  = ticker -> intervals [interval];
+	BKSlideState    * deltas     = ticker -> slides [delta];
+	BKSlideState    * slideSteps = ticker -> slides [steps];
+	BKUInt const    * effects    = ticker -> effects;
+	BKUInt          * active     = ticker -> active;
+	BKUInt          * changes    = ticker -> changes;
+	BKUInt          * updates    = ticker -> updates;
+	BKUInt            changed    = 1 << (BK_TRACK_TICKER_NUM_SLIDES + interval);
+	BKUInt            bits       = changed | (1 << delta);
+	BKInt             value;
+
+	for (BKUInt i = 0; i < ticker -> numTracks; i ++) {
+		if ((effects [i] & effectFlag) == 0 || (active [i] & bits) == 0) {
+			continue;
+		}
+
+		value = BKIntervalStateGetValue (& intervals [i]);
+
+		if (active [i] & (1 << delta)) {
+			BKSlideStateStep (& deltas [i]);
+			BKSlideStateStep (& slideSteps [i]);
+
+			BKIntervalStateSetDeltaAndSteps (
+				& intervals [i],
+				BKSlideStateGetValue (& deltas [i]),
+				BKSlideStateGetValue (& slideSteps [i])
+			);
+
+			changes [i] |= changed | (1 << delta) | (1 << steps);
+
+			if (intervals [i].steps) {
+				active [i] |= changed;
+			}
+			else {
+				active [i] &= ~changed;
+			}
+		}
+
+		if (active [i] & changed) {
+			BKIntervalStateStep (& intervals [i]);
+			changes [i] |= changed;
+		}
+
+		if (BKIntervalStateGetValue (& intervals [i]) != value) {
+			updates [i] |= updateFlag;
+		}
+	}
+}
+
+/**
+ * Tick all tracks of ticker
+ * Each effect is stepped for all tracks in one loop; the changed states are
+ * written back on the next tick or when they are accessed before
+ */
+static BKEnum BKTrackTickerTick (BKCallbackInfo * info, BKTrackTicker * ticker)
+{
+	BKTrack * track;
+	BKUInt    effects = 0;
+
+	// 1.-3. Tick arpeggio and instrument and update units
+	// backwards as sleeping tracks are replaced by the last track
+
+	for (BKUInt i = ticker -> numTracks; i > 0; i --) {
+		track = ticker -> tracks [i - 1];
+
+		if (i > 1) {
+			BK_PREFETCH (ticker -> tracks [i - 2]);
+		}
+
+		// write back states changed by the previous tick before updating unit
+		if (ticker -> changes [i - 1]) {
+			BKTrackTickerStore (ticker, track);
+		}
+
+		ticker -> effects [i - 1] = BKTrackTickUnit (track) ? (track -> flags & BKEffectMask) : 0;
+		effects |= ticker -> effects [i - 1];
+
+		// effect states have been changed by setting attributes
+		if (track -> flags & BKTrackBatchLoadFlag) {
+			BKTrackTickerLoad (ticker, track);
+		}
+
+		// 5. Sleep until woken by setting an attribute
+		// tracks with effects are not idle
+
+		if (BKTrackIsIdle (track)) {
+			BKTrackSleep (track);
+		}
+	}
+
+	// 4. Step each effect of all tracks
+
+	if (effects & BKPortamentoFlag) {
+		BKTrackTickerStepSlides (ticker, BKTrackTickerSlideNote, BKPortamentoFlag, BKTrackEffectUpdateFlagNote);
+	}
+
+	if (effects & BKVolumeSlideFlag) {
+		BKTrackTickerStepSlides (ticker, BKTrackTickerSlideVolume, BKVolumeSlideFlag, BKTrackEffectUpdateFlagVolume);
+	}
+
+	if (effects & BKPanningSlideFlag) {
+		BKTrackTickerStepSlides (ticker, BKTrackTickerSlidePanning, BKPanningSlideFlag, BKTrackEffectUpdateFlagVolume);
+	}
+
+	if (effects & BKTremoloFlag) {
+		BKTrackTickerStepIntervals (ticker, BKTrackTickerIntervalTremolo, BKTrackTickerSlideTremoloDelta,
+			BKTrackTickerSlideTremoloSteps, BKTremoloFlag, BKTrackEffectUpdateFlagVolume);
+	}
+
+	if (effects & BKVibratoFlag) {
+		BKTrackTickerStepIntervals (ticker, BKTrackTickerIntervalVibrato, BKTrackTickerSlideVibratoDelta,
+			BKTrackTickerSlideVibratoSteps, BKVibratoFlag, BKTrackEffectUpdateFlagNote);
 	}
 
 	return 0;
 }
 
+BKInt BKTrackTickerAlloc (BKTrackTicker ** outTicker, BKContext * ctx)
+{
+	BKInt           res;
+	BKCallback      callback;
+	BKTrackTicker * ticker;
+
+	ticker = calloc (1, sizeof (*ticker));
+
+	if (ticker == NULL) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	callback.func     = (BKCallbackFunc) BKTrackTickerTick;
+	callback.userInfo = ticker;
+
+	if (BKDividerInit (& ticker -> divider, 1, & callback) < 0) {
+		free (ticker);
+		return BK_ALLOCATION_ERROR;
+	}
+
+	if ((res = BKContextAttachDivider (ctx, & ticker -> divider, BK_CLOCK_TYPE_EFFECT)) != 0) {
+		BKTrackTickerDispose (ticker);
+		return res;
+	}
+
+	* outTicker = ticker;
+
+	return 0;
+}
+
+void BKTrackTickerDispose (BKTrackTicker * ticker)
+{
+	BKDispose (& ticker -> divider);
+
+	free (ticker -> tracks);
+	free (ticker -> effects);
+	free (ticker -> active);
+	free (ticker -> changes);
+	free (ticker -> updates);
+
+	for (BKInt i = 0; i < BK_TRACK_TICKER_NUM_SLIDES; i ++)
+		free (ticker -> slides [i]);
+
+	for (BKInt i = 0; i < BK_TRACK_TICKER_NUM_INTERVALS; i ++)
+		free (ticker -> intervals [i]);
+
+	free (ticker);
+}
+
 static BKEnum BKTrackSampleDataStateCallback (BKEnum event, BKTrack * track)
 {
 	BKEnum res;
@@ -397,6 +988,11 @@ static BKInt BKTrackInitGeneric (BKTrack * track, BKEnum waveform)
 	track -> flags     |= BKTriangleIgnoresVolumeFlag;
 	track -> unit.run   = (BKUnitRunFunc) BKTrackRun;
 	track -> unit.reset = (BKUnitResetFunc) BKTrackReset;
+	track -> unit.copyState = (BKUnitCopyStateFunc) BKTrackCopyState;
+
+	// pan gains are kept by `BKTrackClear`
+	for (BKInt i = 0; i < BK_MAX_CHANNELS; i ++)
+		track -> panGains [i] = 1 << BK_VOLUME_SHIFT;
 
 	// init waveform flags
 	BKSetAttr (track, BK_WAVEFORM, waveform);
@@ -453,6 +1049,121 @@ static BKInt BKTrackRun (BKTrack * track, BKFUInt20 endTime)
 	return BKUnitRun (& track -> unit, endTime);
 }
 
+/**
+ * Copy unit state followed by track state
+ */
+static BKSize BKTrackCopyState (BKTrack * track, void * state, BKInt restore)
+{
+	BKSize                 unitSize;
+	BKTrackState           trackState;
+	char                 * trackStatePtr;
+	BKSequenceState      * sequenceState;
+	BKTrackSequenceState * sequence;
+
+	if (state) {
+		BKTrackTickerFlush (track);
+	}
+
+	// restored state may be audible
+	if (state && restore)
+		BKTrackWake (track);
+
+	unitSize = BKUnitCopyState (& track -> unit, state, restore);
+
+	if (state == NULL) {
+		return unitSize + sizeof (trackState);
+	}
+
+	// `state` may not be aligned
+	trackStatePtr = (char *) state + unitSize;
+
+	if (restore) {
+		memcpy (& trackState, trackStatePtr, sizeof (trackState));
+
+		// keep how the track is ticked
+		track -> flags           = (trackState.flags & ~BKTrackBatchTickFlag) | (track -> flags & BKTrackBatchTickFlag) | BKTrackBatchLoadFlag;
+		track -> arpeggioDivider = trackState.arpeggioDivider;
+		track -> instrDivider    = trackState.instrDivider;
+		track -> effectDivider   = trackState.effectDivider;
+		track -> dutyCycle       = trackState.dutyCycle;
+		track -> samplePitch     = trackState.samplePitch;
+		track -> masterVolume    = trackState.masterVolume;
+		track -> volume          = trackState.volume;
+		track -> panning         = trackState.panning;
+		track -> curNote         = trackState.curNote;
+		track -> note            = trackState.note;
+		track -> pitch           = trackState.pitch;
+		track -> tremolo         = trackState.tremolo;
+		track -> tremoloDelta    = trackState.tremoloDelta;
+		track -> tremoloSteps    = trackState.tremoloSteps;
+		track -> vibrato         = trackState.vibrato;
+		track -> vibratoDelta    = trackState.vibratoDelta;
+		track -> vibratoSteps    = trackState.vibratoSteps;
+		track -> arpeggio        = trackState.arpeggio;
+
+		track -> instrState.phase              = trackState.instrPhase;
+		track -> instrState.numActiveSequences = trackState.numActiveSequences;
+	}
+	else {
+		memset (& trackState, 0, sizeof (trackState));
+
+		trackState.flags           = track -> flags & ~(BKTrackBatchTickFlag | BKTrackBatchLoadFlag);
+		trackState.arpeggioDivider = track -> arpeggioDivider;
+		trackState.instrDivider    = track -> instrDivider;
+		trackState.effectDivider   = track -> effectDivider;
+		trackState.dutyCycle       = track -> dutyCycle;
+		trackState.samplePitch     = track -> samplePitch;
+		trackState.masterVolume    = track -> masterVolume;
+		trackState.volume          = track -> volume;
+		trackState.panning         = track -> panning;
+		trackState.curNote         = track -> curNote;
+		trackState.note            = track -> note;
+		trackState.pitch           = track -> pitch;
+		trackState.tremolo         = track -> tremolo;
+		trackState.tremoloDelta    = track -> tremoloDelta;
+		trackState.tremoloSteps    = track -> tremoloSteps;
+		trackState.vibrato         = track -> vibrato;
+		trackState.vibratoDelta    = track -> vibratoDelta;
+		trackState.vibratoSteps    = track -> vibratoSteps;
+		trackState.arpeggio        = track -> arpeggio;
+
+		trackState.instrPhase         = track -> instrState.phase;
+		trackState.numActiveSequences = track -> instrState.numActiveSequences;
+	}
+
+	for (BKInt i = 0; i < BK_MAX_SEQUENCES; i ++) {
+		sequenceState = & track -> instrState.states [i];
+		sequence      = & trackState.sequences [i];
+
+		if (restore) {
+			sequenceState -> phase        = sequence -> phase;
+			sequenceState -> steps        = sequence -> steps;
+			sequenceState -> delta        = sequence -> delta;
+			sequenceState -> offset       = sequence -> offset;
+			sequenceState -> value        = sequence -> value;
+			sequenceState -> shiftedValue = sequence -> shiftedValue;
+			sequenceState -> endValue     = sequence -> endValue;
+			sequenceState -> index        = sequence -> index;
+		}
+		else {
+			sequence -> phase        = sequenceState -> phase;
+			sequence -> steps        = sequenceState -> steps;
+			sequence -> delta        = sequenceState -> delta;
+			sequence -> offset       = sequenceState -> offset;
+			sequence -> value        = sequenceState -> value;
+			sequence -> shiftedValue = sequenceState -> shiftedValue;
+			sequence -> endValue     = sequenceState -> endValue;
+			sequence -> index        = sequenceState -> index;
+		}
+	}
+
+	if (!restore) {
+		memcpy (trackStatePtr, & trackState, sizeof (trackState));
+	}
+
+	return unitSize + sizeof (trackState);
+}
+
 void BKTrackReset (BKTrack * track)
 {
 	BKUnitReset (& track -> unit);
@@ -466,6 +1177,9 @@ void BKTrackClear (BKTrack * track)
 	BKInt  dutyCycle    = track -> dutyCycle;
 	BKInt  masterVolume = track -> masterVolume;
 
+	// states are overwritten by pending ones otherwise
+	BKTrackTickerFlush (track);
+
 	BKUnitClear (& track -> unit);
 
 	BKTrackSetInstrument (track, NULL);
@@ -473,7 +1187,8 @@ void BKTrackClear (BKTrack * track)
 	// only clear fields after and including "arpeggioDivider" field
 	memset (& track -> arpeggioDivider, 0, sizeof (BKTrack) - offsetof (BKTrack, arpeggioDivider));
 
-	track -> flags &= (BKTriangleIgnoresVolumeFlag | BKIgnoreVolumeFlag | BKPanningEnabledFlag);
+	track -> flags &= (BKTriangleIgnoresVolumeFlag | BKIgnoreVolumeFlag | BKPanningEnabledFlag | BKTrackBatchTickFlag);
+	track -> flags |= BKTrackBatchLoadFlag;
 
 	BKSetAttr (track, BK_ARPEGGIO_DIVIDER, BK_DEFAULT_ARPEGGIO_DIVIDER);
 	BKSetAttr (track, BK_EFFECT_DIVIDER, BK_DEFAULT_EFFECT_DIVIDER);
@@ -510,17 +1225,13 @@ static void BKTrackDisposeObject (BKTrack * track)
 	BKUnitDisposeObject (& track -> unit);
 }
 
-BKInt BKTrackAttach (BKTrack * track, BKContext * ctx)
+BKInt BKTrackAttachUnit (BKTrack * track, BKContext * ctx)
 {
 	BKInt ret;
 
 	ret = BKUnitAttach (& track -> unit, ctx);
 
 	if (ret == 0) {
-		BKContextSetAttrInt (ctx, BK_CLOCK_TYPE_EFFECT, 1);
-
-		BKContextAttachDivider (ctx, & track -> divider, BK_CLOCK_TYPE_EFFECT);
-
 		if (ctx -> numChannels == 2)
 			track -> flags |= (BKPanningEnabledFlag);
 
@@ -531,8 +1242,46 @@ BKInt BKTrackAttach (BKTrack * track, BKContext * ctx)
 	return ret;
 }
 
+BKInt BKTrackAttach (BKTrack * track, BKContext * ctx)
+{
+	BKInt ret;
+
+	ret = BKTrackAttachUnit (track, ctx);
+
+	if (ret != 0) {
+		return ret;
+	}
+
+	if (ctx -> ticker) {
+		if ((ret = BKTrackTickerAdd (ctx -> ticker, track)) != 0) {
+			BKUnitDetach (& track -> unit);
+			return ret;
+		}
+
+		track -> flags |= BKTrackBatchTickFlag;
+	}
+	else {
+		BKContextSetAttrInt (ctx, BK_CLOCK_TYPE_EFFECT, 1);
+
+		BKContextAttachDivider (ctx, & track -> divider, BK_CLOCK_TYPE_EFFECT);
+	}
+
+	return 0;
+}
+
 void BKTrackDetach (BKTrack * track)
 {
+	if (track -> flags & BKTrackBatchTickFlag) {
+		if ((track -> unit.object.flags & BKUnitFlagSleeping) == 0) {
+			BKTrackTickerRemove (track -> unit.ctx -> ticker, track);
+		}
+
+		track -> flags &= ~BKTrackBatchTickFlag;
+	}
+
+	// sleeping flag is cleared by detaching unit
+	track -> divider.callback.func = (BKCallbackFunc) BKTrackTick;
+
 	BKDividerDetach (& track -> divider);
 	BKUnitDetach (& track -> unit);
 
@@ -545,7 +1294,7 @@ static void BKTrackSetVolume (BKTrack * track, BKInt volume)
 
 	BKSlideStateSetValue (& track -> volume, volume);
 
-	track -> flags |= BKTrackAttrUpdateFlagVolume;
+	track -> flags |= BKTrackAttrUpdateFlagVolume | BKTrackBatchLoadFlag;
 }
 
 static void BKTrackSetPanning (BKTrack * track, BKInt panning)
@@ -554,7 +1303,7 @@ static void BKTrackSetPanning (BKTrack * track, BKInt panning)
 
 	BKSlideStateSetValue (& track -> panning, panning);
 
-	track -> flags |= BKTrackAttrUpdateFlagVolume;
+	track -> flags |= BKTrackAttrUpdateFlagVolume | BKTrackBatchLoadFlag;
 }
 
 static void BKTrackSetInstrumentInitValues (BKTrack * track)
@@ -644,7 +1393,7 @@ static void BKTrackSetNote (BKTrack * track, BKInt note)
 		BKUnitSetAttr (& track -> unit, BK_FLAG_RELEASE, 0);
 	}
 
-	track -> flags |= BKTrackAttrUpdateFlagNote;
+	track -> flags |= BKTrackAttrUpdateFlagNote | BKTrackBatchLoadFlag;
 }
 
 static void BKTrackSetInstrument (BKTrack * track, BKInstrument * instrument)
@@ -681,6 +1430,12 @@ static BKInt BKTrackSetAttrInt (BKTrack * track, BKEnum attr, BKInt value)
 	BKInt ret = 0;
 	BKInt values [2];
 
+	BKTrackTickerFlush (track);
+
+	if ((ret = BKTrackWake (track)) != 0) {
+		return ret;
+	}
+
 	switch (attr) {
 		case BK_MASTER_VOLUME: {
 			value = BKClamp (value, 0, BK_MAX_VOLUME);
@@ -848,6 +1603,8 @@ BKInt BKTrackSetEffect (BKTrack * track, BKEnum effect, void const * inValues, B
 	BKInt steps, delta, slideSteps;
 	BKInt values [3];
 
+	BKTrackTickerFlush (track);
+
 	if (inValues) {
 		size = BKMin (size, sizeof (values));
 		memcpy (values, inValues, size);
@@ -920,6 +1677,8 @@ BKInt BKTrackSetEffect (BKTrack * track, BKEnum effect, void const * inValues, B
 
 	flag = (1 << (effect + BK_EFFECT_FLAG_SHIFT));
 
+	track -> flags |= BKTrackBatchLoadFlag;
+
 	if (values [0]) {
 		track -> flags |= flag;
 	}
@@ -982,6 +1741,12 @@ static BKInt BKTrackSetPtrObj (BKTrack * track, BKEnum attr, void * ptr, BKSize
 	BKInt res;
 	BKInt oldAttr;
 
+	BKTrackTickerFlush (track);
+
+	if ((res = BKTrackWake (track)) != 0) {
+		return res;
+	}
+
 	switch (attr & BK_ATTR_TYPE_MASK) {
 		case BK_EFFECT_TYPE: {
 			BKInt effectValues [3];
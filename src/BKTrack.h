@@ -52,6 +52,12 @@ enum
 	BKTrackAttrUpdateFlagNote      = 1 << 6,
 	BKTrackAttrUpdateFlagDutyCycle = 1 << 7,
 
+	BKTrackEffectUpdateFlagVolume  = 1 << 8, // effect value has changed
+	BKTrackEffectUpdateFlagNote    = 1 << 9,
+
+	BKTrackBatchTickFlag           = 1 << 10, // ticked by `ticker` of context
+	BKTrackBatchLoadFlag           = 1 << 11, // effect states have to be loaded into `ticker`
+
 	BKEffectMask                   = BKPortamentoFlag | BKVolumeSlideFlag
 	| BKPanningSlideFlag | BKTremoloFlag | BKVibratoFlag,
 };
@@ -75,6 +81,9 @@ struct BKTrack
 	BKUnit            unit;
 	BKUInt            flags;
 	BKDivider         divider;
+	BKUInt            tickIndex; // index in `ticker` of context if ticked in batch and not sleeping
+	BKInt             panGains [BK_MAX_CHANNELS]; // channel volume gains of `gainsPanning`
+	BKInt             gainsPanning;
 	BKDividerState    arpeggioDivider;
 	BKDividerState    instrDivider;
 	BKDividerState    effectDivider;
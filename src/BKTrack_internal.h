@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2012-2016 Simon Schoenenberger
+ * http://blipkit.audio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#ifndef _BK_TRACK_INTERNAL_H_
+#define _BK_TRACK_INTERNAL_H_
+
+#include "BKTrack.h"
+
+/**
+ * Effect states stepped by `BKTrackTicker`
+ */
+enum
+{
+	BKTrackTickerSlideNote,
+	BKTrackTickerSlideVolume,
+	BKTrackTickerSlidePanning,
+	BKTrackTickerSlideTremoloDelta,
+	BKTrackTickerSlideTremoloSteps,
+	BKTrackTickerSlideVibratoDelta,
+	BKTrackTickerSlideVibratoSteps,
+	BK_TRACK_TICKER_NUM_SLIDES,
+};
+
+enum
+{
+	BKTrackTickerIntervalTremolo,
+	BKTrackTickerIntervalVibrato,
+	BK_TRACK_TICKER_NUM_INTERVALS,
+};
+
+/**
+ * Ticks all tracks attached to a context with BK_BATCH_TICKS set
+ *
+ * The effect states of the tracks are kept in one array per effect state
+ * indexed by `tickIndex` of the track. States are loaded from a track after
+ * its attributes have been set and are written back into the track before it
+ * is ticked again or before its attributes are accessed
+ *
+ * The bits of `active` and `changes` are set for slide `i` at `1 << i` and for
+ * interval `i` at `1 << (BK_TRACK_TICKER_NUM_SLIDES + i)`. The delta slide of
+ * an interval is active if it has steps set; its steps slide has no bit
+ */
+struct BKTrackTicker
+{
+	BKDivider         divider;
+	BKUInt            numTracks;
+	BKUInt            capacity;
+	BKTrack        ** tracks;  // awake tracks
+	BKUInt          * effects; // effect flags stepped on the current tick
+	BKUInt          * active;  // states which change when stepped
+	BKUInt          * changes; // states changed by the previous tick
+	BKUInt          * updates; // effect update flags of the previous tick
+	BKSlideState    * slides [BK_TRACK_TICKER_NUM_SLIDES];
+	BKIntervalState * intervals [BK_TRACK_TICKER_NUM_INTERVALS];
+};
+
+/**
+ * Tick arpeggio, instrument and effects and update unit
+ * This is the callback of the track divider
+ */
+extern BKEnum BKTrackTick (BKCallbackInfo * info, BKTrack * track);
+
+/**
+ * Attach unit to context without attaching the track divider
+ * The track has to be ticked with `BKTrackTick`
+ *
+ * Errors:
+ * BK_INVALID_STATE if already attached to a context
+ */
+extern BKInt BKTrackAttachUnit (BKTrack * track, BKContext * ctx);
+
+/**
+ * Allocate ticker and attach its divider to context
+ *
+ * Errors:
+ * BK_ALLOCATION_ERROR if memory could not be allocated
+ */
+extern BKInt BKTrackTickerAlloc (BKTrackTicker ** outTicker, BKContext * ctx);
+
+/**
+ * Detach divider and free ticker
+ * All tracks have to be detached
+ */
+extern void BKTrackTickerDispose (BKTrackTicker * ticker);
+
+#endif /* ! _BK_TRACK_INTERNAL_H_ */
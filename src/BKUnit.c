@@ -51,6 +51,31 @@ static BKFrame const squarePhases [BK_SQUARE_PHASES + 1][BK_SQUARE_PHASES] =
 	{  MIV, MIV, MIV, MIV, MIV, MIV, MIV, MIV, MIV, MIV, MIV, MIV, MIV, MIV, MIV, 0},
 };
 
+/**
+ * Number of phases until the value of `squarePhases` changes
+ */
+static uint8_t const squareEdgeSteps [BK_SQUARE_PHASES + 1][BK_SQUARE_PHASES] =
+{
+	{ 1,  1, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2},
+	{ 1,  1, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2},
+	{ 2,  1,  2,  1, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3},
+	{ 2,  1,  3,  2,  1, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3},
+	{ 3,  2,  1,  4,  3,  2,  1, 12, 11, 10,  9,  8,  7,  6,  5,  4},
+	{ 3,  2,  1,  5,  4,  3,  2,  1, 11, 10,  9,  8,  7,  6,  5,  4},
+	{ 4,  3,  2,  1,  6,  5,  4,  3,  2,  1, 10,  9,  8,  7,  6,  5},
+	{ 4,  3,  2,  1,  7,  6,  5,  4,  3,  2,  1,  9,  8,  7,  6,  5},
+	{ 5,  4,  3,  2,  1,  8,  7,  6,  5,  4,  3,  2,  1,  8,  7,  6},
+
+	{ 6,  5,  4,  3,  2,  1,  9,  8,  7,  6,  5,  4,  3,  2,  1,  7},
+	{ 5,  4,  3,  2,  1, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  6},
+	{ 4,  3,  2,  1, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  5},
+	{ 3,  2,  1, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  4},
+	{ 2,  1, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  3},
+	{ 1, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  2},
+	{15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  1},
+	{15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  1},
+};
+
 static BKFrame const trianglePhases [BK_TRIANGLE_PHASES] =
 {
 	     0,   2047,   4095,   6143,   8191,  10239,  12287,  14335,
@@ -59,6 +84,15 @@ static BKFrame const trianglePhases [BK_TRIANGLE_PHASES] =
 	-16383, -14335, -12287, -10239,  -8191,  -6143,  -4095,  -2047,
 };
 
+/**
+ * Number of phases until the value of `trianglePhases` changes
+ */
+static uint8_t const triangleEdgeSteps [BK_TRIANGLE_PHASES] =
+{
+	1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
 static BKFrame const sawtoothPhases [BK_SAWTOOTH_PHASES] =
 {
 	 32766,  27305,  21844,  16383,  10922,   5461,      0,
@@ -72,6 +106,47 @@ static BKFrame const sinePhases [BK_SINE_PHASES] =
 	-32767, -32137, -30272, -27244, -23169, -18204, -12539,  -6392,
 };
 
+#define BK_UNIT_EDGES_SIZE 64
+
+typedef struct BKUnitEdges BKUnitEdges;
+
+/**
+ * Waveform edges generated once per unit and shared by all channels
+ */
+struct BKUnitEdges
+{
+	BKUInt    count;
+	BKFUInt20 times [BK_UNIT_EDGES_SIZE];
+	BKInt     pulses [BK_UNIT_EDGES_SIZE];
+};
+
+typedef struct BKUnitState BKUnitState;
+
+/**
+ * Run state of unit without references to other objects
+ */
+struct BKUnitState
+{
+	BKUInt    flags;
+	BKFUInt20 time;
+	BKFUInt20 period;
+	BKInt     lastPulse [BK_MAX_CHANNELS];
+	BKUInt    dutyCycle;
+	BKInt     volume [BK_MAX_CHANNELS];
+	BKInt     mute;
+	BKUInt    phase;
+	BKUInt    wrap;
+	BKInt     wrapCount;
+	BKUInt    offset;
+	BKUInt    end;
+	BKUInt    repeatMode;
+	BKUInt    repeatCount;
+	BKUInt    sustainOffset;
+	BKUInt    sustainEnd;
+	BKFInt20  timeFrac;
+	BKFInt20  samplePeriod;
+};
+
 static BKEnum BKUnitCallSampleCallback (BKUnit * unit, BKEnum event);
 static void BKUnitUpdateSampleSustainRange (BKUnit * unit, BKInt offset, BKInt end);
 
@@ -88,13 +163,13 @@ static BKInt BKUnitTrySetData (BKUnit * unit, BKData * data, BKEnum type, BKEnum
 		case BK_WAVEFORM: {
 			if (data && event != BK_DATA_STATE_EVENT_DISPOSE) {
 				if (data -> numFrames >= 2) {
-					unit -> waveform           = BK_CUSTOM;
-					unit -> phase.count        = data -> numFrames;
-					unit -> phase.phase        = 0;
-					unit -> sample.offset      = 0;
-					unit -> sample.end         = data -> numFrames;
-					unit -> sample.frames      = data -> frames;
-					unit -> sample.repeatCount = 0;
+					unit -> waveform             = BK_CUSTOM;
+					unit -> state -> phase.count = data -> numFrames;
+					unit -> state -> phase.phase = 0;
+					unit -> sample.offset        = 0;
+					unit -> sample.end           = data -> numFrames;
+					unit -> sample.frames        = data -> frames;
+					unit -> sample.repeatCount   = 0;
 				}
 				else {
 					return BK_INVALID_NUM_FRAMES;
@@ -124,14 +199,14 @@ static BKInt BKUnitTrySetData (BKUnit * unit, BKData * data, BKEnum type, BKEnum
 				}
 				else {
 					unit -> waveform             = BK_SAMPLE;
-					unit -> phase.count          = 1;  // prevent divion by 0
+					unit -> state -> phase.count = 1;  // prevent divion by 0
 					unit -> sample.length        = data -> numFrames;
 					unit -> sample.numChannels   = data -> numChannels;
 					unit -> sample.offset        = 0;
 					unit -> sample.end           = data -> numFrames;
 					unit -> sample.frames        = data -> frames;
 					unit -> sample.period        = BKAbs (unit -> sample.period);
-					unit -> phase.phase          = 0; // reset phase
+					unit -> state -> phase.phase = 0; // reset phase
 					unit -> sample.repeatMode    = 0;
 					unit -> sample.repeatCount   = 0;
 					unit -> sample.sustainOffset = 0;
@@ -150,7 +225,7 @@ static BKInt BKUnitTrySetData (BKUnit * unit, BKData * data, BKEnum type, BKEnum
 				unit -> sample.sustainOffset = 0;
 				unit -> sample.sustainEnd    = 0;
 				unit -> sample.frames        = NULL;
-				unit -> phase.phase          = 0; // reset phase
+				unit -> state -> phase.phase = 0; // reset phase
 				unit -> sample.repeatMode    = 0;
 
 				BKBitUnset (unit -> object.flags, BKUnitFlagSampleSustainRange | BKUnitFlagSampleSustainJump | BKUnitFlagRelease);
@@ -235,9 +310,11 @@ BKInt BKUnitInit (BKUnit * unit, BKEnum waveform)
 		return -1;
 	}
 
+	unit -> state = & unit -> ownState;
 	unit -> run   = (BKUnitRunFunc) BKUnitRun;
 	unit -> end   = (BKUnitEndFunc) BKUnitEnd;
 	unit -> reset = (BKUnitResetFunc) BKUnitReset;
+	unit -> copyState = (BKUnitCopyStateFunc) BKUnitCopyState;
 
 	BKSetAttr (unit, BK_DUTY_CYCLE, BK_DEFAULT_DUTY_CYCLE);
 	BKSetAttr (unit, BK_WAVEFORM, waveform);
@@ -257,13 +334,67 @@ void BKUnitDisposeObject (BKUnit * unit)
 	BKUnitDetach (unit);
 }
 
+/**
+ * Append unit to `units` of context and move its run state into `unitStates`
+ */
+static BKInt BKUnitPushIndex (BKUnit * unit, BKContext * ctx)
+{
+	BKUnit        ** unitRef;
+	BKUnitRunState * states = ctx -> unitStates.items;
+	BKUnitRunState * state;
+	BKUnit        ** units;
+
+	if (BKArrayReserve (& ctx -> units, 1) != 0) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	state = BKArrayPush (& ctx -> unitStates);
+
+	if (state == NULL) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	unitRef = BKArrayPush (& ctx -> units);
+
+	(* unitRef) = unit;
+	(* state)   = unit -> ownState;
+
+	unit -> unitIndex = (BKUInt) ctx -> units.len - 1;
+	unit -> state     = state;
+
+	// states have been moved
+	if (ctx -> unitStates.items != states) {
+		units  = ctx -> units.items;
+		states = ctx -> unitStates.items;
+
+		for (BKUInt i = 0; i < ctx -> units.len; i ++)
+			units [i] -> state = & states [i];
+	}
+
+	return 0;
+}
+
 BKInt BKUnitAttach (BKUnit * unit, BKContext * ctx)
 {
+	BKInt res;
+
+	// `units` of context is read by worker threads
+	if (ctx -> flags & BK_CONTEXT_FLAG_WORKERS) {
+		return BK_INVALID_STATE;
+	}
+
 	if (unit -> ctx == NULL) {
-		unit -> prevUnit = ctx -> lastUnit;
-		unit -> nextUnit = NULL;
-		unit -> ctx      = ctx;
-		unit -> time     = ctx -> deltaTime;  // shift time to context time
+		res = BKUnitPushIndex (unit, ctx);
+
+		if (res != 0) {
+			return res;
+		}
+
+		unit -> prevUnit      = ctx -> lastUnit;
+		unit -> nextUnit      = NULL;
+		unit -> ctx           = ctx;
+		unit -> channels      = ctx -> channels;
+		unit -> state -> time = ctx -> deltaTime;  // shift time to context time
 
 		if (ctx -> lastUnit) {
 			ctx -> lastUnit -> nextUnit = unit;
@@ -282,11 +413,46 @@ BKInt BKUnitAttach (BKUnit * unit, BKContext * ctx)
 	return 0;
 }
 
+/**
+ * Remove unit from `units` of context and move its run state back into the unit
+ */
+static void BKUnitRemoveIndex (BKUnit * unit)
+{
+	BKContext      * ctx    = unit -> ctx;
+	BKUnit        ** units  = ctx -> units.items;
+	BKUnitRunState * states = ctx -> unitStates.items;
+	BKUInt           index  = unit -> unitIndex;
+
+	unit -> ownState = states [index];
+
+	// move last unit to free index
+	ctx -> unitStates.len --;
+	units [index]  = units [-- ctx -> units.len];
+	states [index] = states [ctx -> units.len];
+	units [index] -> unitIndex = index;
+	units [index] -> state     = & states [index];
+
+	// may have been the last unit
+	unit -> state = & unit -> ownState;
+}
+
 void BKUnitDetach (BKUnit * unit)
 {
 	BKContext * ctx = unit -> ctx;
 
 	if (ctx) {
+		// `units` of context is read by worker threads
+		if (ctx -> flags & BK_CONTEXT_FLAG_WORKERS) {
+			return;
+		}
+
+		if (unit -> object.flags & BKUnitFlagSleeping) {
+			unit -> object.flags &= ~BKUnitFlagSleeping;
+		}
+		else {
+			BKUnitRemoveIndex (unit);
+		}
+
 		if (unit -> prevUnit) {
 			unit -> prevUnit -> nextUnit = unit -> nextUnit;
 		}
@@ -303,11 +469,53 @@ void BKUnitDetach (BKUnit * unit)
 			ctx -> lastUnit = unit -> prevUnit;
 		}
 
-		unit -> ctx  = NULL;
-		unit -> time = 0;
+		unit -> ctx           = NULL;
+		unit -> channels      = NULL;
+		unit -> state -> time = 0;
 	}
 }
 
+void BKUnitSleep (BKUnit * unit)
+{
+	if (unit -> ctx == NULL || (unit -> object.flags & BKUnitFlagSleeping)) {
+		return;
+	}
+
+	if (unit -> ctx -> flags & BK_CONTEXT_FLAG_WORKERS) {
+		return;
+	}
+
+	BKUnitRemoveIndex (unit);
+
+	unit -> object.flags |= BKUnitFlagSleeping;
+}
+
+BKInt BKUnitWake (BKUnit * unit)
+{
+	BKContext * ctx = unit -> ctx;
+	BKInt       res;
+
+	if ((unit -> object.flags & BKUnitFlagSleeping) == 0) {
+		return 0;
+	}
+
+	if (ctx -> flags & BK_CONTEXT_FLAG_WORKERS) {
+		return BK_INVALID_STATE;
+	}
+
+	res = BKUnitPushIndex (unit, ctx);
+
+	if (res != 0) {
+		return res;
+	}
+
+	unit -> channels      = ctx -> channels;
+	unit -> state -> time = ctx -> unitTime; // time was not shifted while sleeping
+	unit -> object.flags &= ~BKUnitFlagSleeping;
+
+	return 0;
+}
+
 static void BKUnitUpdateSampleRange (BKUnit * unit, BKInt offset, BKInt end)
 {
 	BKInt sampleLength;
@@ -330,7 +538,7 @@ static void BKUnitUpdateSampleRange (BKUnit * unit, BKInt offset, BKInt end)
 	newOffset = BKMin (offset, end);
 	newLength = BKAbs (offset - end);
 
-	newPhase = unit -> phase.phase + (oldOffset - newOffset);
+	newPhase = unit -> state -> phase.phase + (oldOffset - newOffset);
 
 	// reset phase if it would overlap the new range
 	if (newPhase < 0 || newPhase >= newLength)
@@ -349,16 +557,16 @@ static void BKUnitUpdateSampleRange (BKUnit * unit, BKInt offset, BKInt end)
 	// if not playing yet
 	if (unit -> sample.repeatCount == 0) {
 		// set sample phase to begin if sample phase is at end
-		if (unit -> sample.offset < unit -> sample.end && unit -> phase.phase == unit -> sample.length - 1) {
+		if (unit -> sample.offset < unit -> sample.end && unit -> state -> phase.phase == unit -> sample.length - 1) {
 			newPhase = 0;
 		}
 		// set sample phase to end if sample phase is at begin
-		else if (unit -> phase.phase == 0) {
+		else if (unit -> state -> phase.phase == 0) {
 			newPhase = unit -> sample.length - 1;
 		}
 	}
 
-	unit -> phase.phase = newPhase;
+	unit -> state -> phase.phase = newPhase;
 }
 
 static void BKUnitUpdateSampleSustainRange (BKUnit * unit, BKInt offset, BKInt end)
@@ -399,44 +607,33 @@ BKInt BKUnitSetAttr (BKUnit * unit, BKEnum attr, BKInt value)
 {
 	switch (attr) {
 		case BK_DUTY_CYCLE: {
-			value = BKClamp (value, BK_MIN_DUTY_CYCLE, BK_MAX_DUTY_CYCLE);
-
-			if (unit -> dutyCycle != value) {
-				if (unit -> waveform == BK_SQUARE) {
-					// reduce clicking noise
-					if (value > unit -> dutyCycle && unit -> phase.phase < value)
-						unit -> phase.phase = 0;
-				}
-
-				unit -> dutyCycle = value;
-			}
-
+			BKUnitSetDutyCycle (unit, value);
 			break;
 		}
 		case BK_WAVEFORM: {
 			switch (value) {
 				case 0: {
-					unit -> phase.count = BK_SQUARE_PHASES;
+					unit -> state -> phase.count = BK_SQUARE_PHASES;
 					break;
 				}
 				case BK_SQUARE: {
-					unit -> phase.count = BK_SQUARE_PHASES;
+					unit -> state -> phase.count = BK_SQUARE_PHASES;
 					break;
 				}
 				case BK_TRIANGLE: {
-					unit -> phase.count = BK_TRIANGLE_PHASES;
+					unit -> state -> phase.count = BK_TRIANGLE_PHASES;
 					break;
 				}
 				case BK_NOISE: {
-					unit -> phase.count = BK_NOISE_PHASES;
+					unit -> state -> phase.count = BK_NOISE_PHASES;
 					break;
 				}
 				case BK_SAWTOOTH: {
-					unit -> phase.count = BK_SAWTOOTH_PHASES;
+					unit -> state -> phase.count = BK_SAWTOOTH_PHASES;
 					break;
 				}
 				case BK_SINE: {
-					unit -> phase.count = BK_SINE_PHASES;
+					unit -> state -> phase.count = BK_SINE_PHASES;
 					break;
 				}
 				default: {
@@ -446,8 +643,8 @@ BKInt BKUnitSetAttr (BKUnit * unit, BKEnum attr, BKInt value)
 			}
 
 			if (unit -> waveform != value) {
-				unit -> phase.phase = 0;
-				unit -> waveform    = value;
+				unit -> state -> phase.phase = 0;
+				unit -> waveform             = value;
 			}
 
 			BKDataStateSetData (& unit -> sample.dataState, NULL);
@@ -456,7 +653,7 @@ BKInt BKUnitSetAttr (BKUnit * unit, BKEnum attr, BKInt value)
 		}
 		case BK_PHASE: {
 			if (unit -> waveform != BK_SAMPLE) {
-				value = BKClamp (value, 0, unit -> phase.count - 1);
+				value = BKClamp (value, 0, unit -> state -> phase.count - 1);
 			}
 			else {
 				// reset to sample start
@@ -473,27 +670,26 @@ BKInt BKUnitSetAttr (BKUnit * unit, BKEnum attr, BKInt value)
 				BKUnitCallSampleCallback (unit, BK_EVENT_SAMPLE_BEGIN);
 			}
 
-			unit -> phase.phase = value;
+			unit -> state -> phase.phase = value;
 
 			break;
 		}
 		case BK_PHASE_WRAP: {
 			value = value ? BKMax (value, 2) : 0;
-			unit -> phase.phase     = 0;
-			unit -> phase.wrap      = value;
-			unit -> phase.wrapCount = value;
+			unit -> state -> phase.phase     = 0;
+			unit -> state -> phase.wrap      = value;
+			unit -> state -> phase.wrapCount = value;
 			break;
 		}
 		case BK_PERIOD: {
-			value = BKMax (BKAbs (value), BK_MIN_PERIOD);
-			unit -> period = value;
+			BKUnitSetPeriod (unit, value);
 			break;
 		}
 		case BK_VOLUME: {
 			value = BKClamp (value, 0, BK_MAX_VOLUME);
 
 			for (BKInt i = 0; i < BK_MAX_CHANNELS; i ++)
-				unit -> volume [i] = value;
+				unit -> state -> volume [i] = value;
 
 			break;
 		}
@@ -506,7 +702,7 @@ BKInt BKUnitSetAttr (BKUnit * unit, BKEnum attr, BKInt value)
 		case BK_VOLUME_6:
 		case BK_VOLUME_7: {
 			value = BKClamp (value, 0, BK_MAX_VOLUME);
-			unit -> volume [attr - BK_VOLUME_0] = value;
+			unit -> state -> volume [attr - BK_VOLUME_0] = value;
 			break;
 		}
 		case BK_MUTE: {
@@ -530,15 +726,7 @@ BKInt BKUnitSetAttr (BKUnit * unit, BKEnum attr, BKInt value)
 			break;
 		}
 		case BK_SAMPLE_PERIOD: {
-			value = BKAbs (value);
-			value = BKClamp (value, BK_MIN_SAMPLE_PERIOD, BK_MAX_SAMPLE_PERIOD);
-
-			// reverse if negative
-			if (unit -> sample.period < 0) {
-				value = -value;
-			}
-
-			unit -> sample.period = value;
+			BKUnitSetSamplePeriod (unit, value);
 			break;
 		}
 		case BK_SAMPLE_IMMED_RELEASE: {
@@ -554,10 +742,10 @@ BKInt BKUnitSetAttr (BKUnit * unit, BKEnum attr, BKInt value)
 				if (value) {
 					if ((unit -> object.flags & BKUnitFlagSampleSustainJump) && unit -> mute == 0) {
 						if (unit -> sample.period > 0) {
-							unit -> phase.phase = unit -> sample.sustainEnd;
+							unit -> state -> phase.phase = unit -> sample.sustainEnd;
 						}
 						else {
-							unit -> phase.phase = BKMax (0, (BKInt) unit -> sample.sustainOffset - 1);
+							unit -> state -> phase.phase = BKMax (0, (BKInt) unit -> sample.sustainOffset - 1);
 						}
 					}
 				}
@@ -588,19 +776,19 @@ BKInt BKUnitGetAttr (BKUnit const * unit, BKEnum attr, BKInt * outValue)
 			break;
 		}
 		case BK_PERIOD: {
-			value = unit -> period;
+			value = unit -> state -> period;
 			break;
 		}
 		case BK_PHASE: {
-			value = unit -> phase.phase;
+			value = unit -> state -> phase.phase;
 			break;
 		}
 		case BK_PHASE_WRAP: {
-			value = unit -> phase.wrap;
+			value = unit -> state -> phase.wrap;
 			break;
 		}
 		case BK_NUM_PHASES: {
-			value = (unit -> waveform != BK_SAMPLE) ? unit -> phase.count : unit -> sample.length;
+			value = (unit -> waveform != BK_SAMPLE) ? unit -> state -> phase.count : unit -> sample.length;
 			break;
 		}
 		case BK_VOLUME_0:
@@ -611,7 +799,7 @@ BKInt BKUnitGetAttr (BKUnit const * unit, BKEnum attr, BKInt * outValue)
 		case BK_VOLUME_5:
 		case BK_VOLUME_6:
 		case BK_VOLUME_7: {
-			value = unit -> volume [attr - BK_VOLUME_0];
+			value = unit -> state -> volume [attr - BK_VOLUME_0];
 			break;
 		}
 		case BK_MUTE: {
@@ -762,75 +950,85 @@ BKInt BKUnitGetPtr (BKUnit const * unit, BKEnum attr, void * outPtr)
 	return 0;
 }
 
-static BKFUInt20 BKUnitRunWaveformSquare (BKUnit * unit, BKBuffer * channel, BKInt * lastPulseRef, BKInt volume, BKFUInt20 time, BKFUInt20 endTime)
+/**
+ * Limit `steps` to the number of periods needed to reach `endTime`
+ */
+BK_INLINE BKUInt BKUnitClampEdgeSteps (BKUInt steps, BKFUInt20 period, BKFUInt20 time, BKFUInt20 endTime)
 {
-	BKInt  pulse;
-	BKInt  dutyCycle = unit -> dutyCycle;
-	BKInt  delta, chanDelta;
-	BKInt  lastPulse = *lastPulseRef;
-	BKUInt phase = unit -> phase.phase;
+	BKFUInt20 remaining = endTime - time;
 
-	// run until time
-	for (; time < endTime; time += unit -> period) {
-		pulse = squarePhases [dutyCycle][phase];
-		phase = (phase + 1) & (BK_SQUARE_PHASES - 1);
-
-		delta = (pulse * volume) >> BK_VOLUME_SHIFT;
+	if (steps * period >= remaining) {
+		steps = (remaining - 1) / period + 1;
+	}
 
-		chanDelta = delta - lastPulse;
-		lastPulse = delta;
+	return steps;
+}
 
-		BKBufferAddPulse (channel, time, chanDelta);
+static BKFUInt20 BKUnitEdgesSquare (BKUnit * unit, BKUnitEdges * edges, BKFUInt20 time, BKFUInt20 endTime)
+{
+	BKUInt count = 0;
+	BKUInt steps;
+	BKInt  dutyCycle = unit -> dutyCycle;
+	BKUInt phase = unit -> state -> phase.phase;
+	BKFUInt20 period = unit -> state -> period;
+
+	// run until time or edges are full
+	// jump directly to the next phase where the value changes
+	while (time < endTime && count < BK_UNIT_EDGES_SIZE) {
+		edges -> times [count]    = time;
+		edges -> pulses [count ++] = squarePhases [dutyCycle][phase];
+
+		steps = BKUnitClampEdgeSteps (squareEdgeSteps [dutyCycle][phase], period, time, endTime);
+		time += steps * period;
+		phase = (phase + steps) & (BK_SQUARE_PHASES - 1);
 	}
 
-	unit -> phase.phase = phase;
-	*lastPulseRef = lastPulse;
+	unit -> state -> phase.phase = phase;
+	edges -> count = count;
 
 	return time;
 }
 
-static BKFUInt20 BKUnitRunWaveformTriangle (BKUnit * unit, BKBuffer * channel, BKInt * lastPulseRef, BKInt volume, BKFUInt20 time, BKFUInt20 endTime)
+static BKFUInt20 BKUnitEdgesTriangle (BKUnit * unit, BKUnitEdges * edges, BKFUInt20 time, BKFUInt20 endTime)
 {
-	BKInt  pulse;
-	BKInt  delta, chanDelta;
-	BKInt  lastPulse = *lastPulseRef;
-	BKUInt phase = unit -> phase.phase;
-
-	// run until time
-	for (; time < endTime; time += unit -> period) {
-		pulse = trianglePhases [phase];
-		phase = (phase + 1) & (BK_TRIANGLE_PHASES - 1);
-
-		delta = (pulse * volume) >> BK_VOLUME_SHIFT;
-
-		chanDelta = delta - lastPulse;
-		lastPulse = delta;
-
-		BKBufferAddPulse (channel, time, chanDelta);
+	BKUInt count = 0;
+	BKUInt steps;
+	BKUInt phase = unit -> state -> phase.phase;
+	BKFUInt20 period = unit -> state -> period;
+
+	// run until time or edges are full
+	// jump directly to the next phase where the value changes
+	while (time < endTime && count < BK_UNIT_EDGES_SIZE) {
+		edges -> times [count]    = time;
+		edges -> pulses [count ++] = trianglePhases [phase];
+
+		steps = BKUnitClampEdgeSteps (triangleEdgeSteps [phase], period, time, endTime);
+		time += steps * period;
+		phase = (phase + steps) & (BK_TRIANGLE_PHASES - 1);
 	}
 
-	unit -> phase.phase = phase;
-	*lastPulseRef = lastPulse;
+	unit -> state -> phase.phase = phase;
+	edges -> count = count;
 
 	return time;
 }
 
-static BKFUInt20 BKUnitRunWaveformNoise (BKUnit * unit, BKBuffer * channel, BKInt * lastPulseRef, BKInt volume, BKFUInt20 time, BKFUInt20 endTime)
+static BKFUInt20 BKUnitEdgesNoise (BKUnit * unit, BKUnitEdges * edges, BKFUInt20 time, BKFUInt20 endTime)
 {
 	BKInt  pulse;
-	BKInt  delta, chanDelta;
-	BKInt  lastPulse = *lastPulseRef;
-	BKUInt phase = unit -> phase.phase;
-	BKUInt wrap = unit -> phase.wrap;
-	BKUInt wrapCount = unit -> phase.wrapCount;
+	BKUInt count = 0;
+	BKUInt phase = unit -> state -> phase.phase;
+	BKFUInt20 period = unit -> state -> period;
+	BKUInt wrap = unit -> state -> phase.wrap;
+	BKUInt wrapCount = unit -> state -> phase.wrapCount;
 
 	// must not be 0
 	if (!phase) {
 		phase = 0x4a41;
 	}
 
-	// run until time
-	for (; time < endTime; time += unit -> period) {
+	// run until time or edges are full
+	for (; time < endTime && count < BK_UNIT_EDGES_SIZE; time += period) {
 		if (wrap) {
 			if (-- wrapCount <= 0) {
 				wrapCount = wrap;
@@ -842,87 +1040,74 @@ static BKFUInt20 BKUnitRunWaveformNoise (BKUnit * unit, BKBuffer * channel, BKIn
 		phase = (phase >> 1) | (pulse << 15);
 		pulse = pulse ? BK_MAX_VOLUME / 2 : -BK_MAX_VOLUME / 2;
 
-		delta = (pulse * volume) >> BK_VOLUME_SHIFT;
-
-		chanDelta = delta - lastPulse;
-		lastPulse = delta;
+		// skip if value does not change
+		if (count && edges -> pulses [count - 1] == pulse) {
+			continue;
+		}
 
-		BKBufferAddPulse (channel, time, chanDelta);
+		edges -> times [count]    = time;
+		edges -> pulses [count ++] = pulse;
 	}
 
-	unit -> phase.phase = phase;
-	unit -> phase.wrapCount = wrapCount;
-	*lastPulseRef = lastPulse;
+	unit -> state -> phase.phase = phase;
+	unit -> state -> phase.wrapCount = wrapCount;
+	edges -> count = count;
 
 	return time;
 }
 
-static BKFUInt20 BKUnitRunWaveformSawtooth (BKUnit * unit, BKBuffer * channel, BKInt * lastPulseRef, BKInt volume, BKFUInt20 time, BKFUInt20 endTime)
+static BKFUInt20 BKUnitEdgesSawtooth (BKUnit * unit, BKUnitEdges * edges, BKFUInt20 time, BKFUInt20 endTime)
 {
-	BKInt  pulse;
-	BKInt  delta, chanDelta;
-	BKInt  lastPulse = *lastPulseRef;
-	BKUInt phase = unit -> phase.phase;
+	BKUInt count = 0;
+	BKUInt phase = unit -> state -> phase.phase;
+	BKFUInt20 period = unit -> state -> period;
 
-	// run until time
-	for (; time < endTime; time += unit -> period) {
-		pulse = sawtoothPhases [phase];
+	// run until time or edges are full
+	for (; time < endTime && count < BK_UNIT_EDGES_SIZE; time += period) {
+		edges -> times [count]    = time;
+		edges -> pulses [count ++] = sawtoothPhases [phase];
 
 		if (++ phase >= BK_SAWTOOTH_PHASES) {
 			phase = 0;
 		}
-
-		delta = (pulse * volume) >> BK_VOLUME_SHIFT;
-
-		chanDelta = delta - lastPulse;
-		lastPulse = delta;
-
-		BKBufferAddPulse (channel, time, chanDelta);
 	}
 
-	unit -> phase.phase = phase;
-	*lastPulseRef = lastPulse;
+	unit -> state -> phase.phase = phase;
+	edges -> count = count;
 
 	return time;
 }
 
-static BKFUInt20 BKUnitRunWaveformSine (BKUnit * unit, BKBuffer * channel, BKInt * lastPulseRef, BKInt volume, BKFUInt20 time, BKFUInt20 endTime)
+static BKFUInt20 BKUnitEdgesSine (BKUnit * unit, BKUnitEdges * edges, BKFUInt20 time, BKFUInt20 endTime)
 {
-	BKInt  pulse;
-	BKInt  delta, chanDelta;
-	BKInt  lastPulse = *lastPulseRef;
-	BKUInt phase = unit -> phase.phase;
-
-	// run until time
-	for (; time < endTime; time += unit -> period) {
-		pulse = sinePhases [phase] / 2;
+	BKUInt count = 0;
+	BKUInt phase = unit -> state -> phase.phase;
+	BKFUInt20 period = unit -> state -> period;
+
+	// run until time or edges are full
+	for (; time < endTime && count < BK_UNIT_EDGES_SIZE; time += period) {
+		edges -> times [count]    = time;
+		edges -> pulses [count ++] = sinePhases [phase] / 2;
 		phase = (phase + 1) & (BK_SINE_PHASES - 1);
-
-		delta = (pulse * volume) >> BK_VOLUME_SHIFT;
-
-		chanDelta = delta - lastPulse;
-		lastPulse = delta;
-
-		BKBufferAddPulse (channel, time, chanDelta);
 	}
 
-	unit -> phase.phase = phase;
-	*lastPulseRef = lastPulse;
+	unit -> state -> phase.phase = phase;
+	edges -> count = count;
 
 	return time;
 }
 
-static BKFUInt20 BKUnitRunWaveformCustom (BKUnit * unit, BKBuffer * channel, BKInt * lastPulseRef, BKInt volume, BKFUInt20 time, BKFUInt20 endTime)
+static BKFUInt20 BKUnitEdgesCustom (BKUnit * unit, BKUnitEdges * edges, BKFUInt20 time, BKFUInt20 endTime)
 {
 	BKInt  pulse;
-	BKInt  delta, chanDelta;
-	BKInt  lastPulse = *lastPulseRef;
-	BKUInt phase = unit -> phase.phase;
-	BKUInt wrap = unit -> phase.wrap;
-	BKUInt wrapCount = unit -> phase.wrapCount;
-
-	// run until time
-	for (; time < endTime; time += unit -> period) {
+	BKUInt count = 0;
+	BKUInt phase = unit -> state -> phase.phase;
+	BKFUInt20 period = unit -> state -> period;
+	BKUInt wrap = unit -> state -> phase.wrap;
+	BKUInt wrapCount = unit -> state -> phase.wrapCount;
+
+	// run until time or edges are full
+	for (; time < endTime && count < BK_UNIT_EDGES_SIZE; time += period) {
 		if (wrap) {
 			if (-- wrapCount <= 0) {
 				wrapCount = wrap;
@@ -932,88 +1117,223 @@ static BKFUInt20 BKUnitRunWaveformCustom (BKUnit * unit, BKBuffer * channel, BKI
 
 		pulse = unit -> sample.frames [phase];
 
-		if (++ phase >= unit -> phase.count) {
+		if (++ phase >= unit -> state -> phase.count) {
 			phase = 0;
 		}
 
-		delta = (pulse * volume) >> BK_VOLUME_SHIFT;
-
-		chanDelta = delta - lastPulse;
-		lastPulse = delta;
+		// skip if value does not change
+		if (count && edges -> pulses [count - 1] == pulse) {
+			continue;
+		}
 
-		BKBufferAddPulse (channel, time, chanDelta);
+		edges -> times [count]    = time;
+		edges -> pulses [count ++] = pulse;
 	}
 
-	unit -> phase.phase = phase;
-	unit -> phase.wrapCount = wrapCount;
-	*lastPulseRef = lastPulse;
+	unit -> state -> phase.phase = phase;
+	unit -> state -> phase.wrapCount = wrapCount;
+	edges -> count = count;
 
 	return time;
 }
 
 /**
- * Fills buffer with waveform to specified time
+ * Scatter edges into each channel with its own volume
  */
-static BKFUInt20 BKUnitRunWaveform (BKUnit * unit, BKFUInt20 endTime)
+static void BKUnitScatterEdges (BKUnit * unit, BKUnitEdges const * edges)
 {
-	BKFUInt20  time = 0;
 	BKInt      volume;
+	BKInt      delta, lastPulse;
 	BKBuffer * channel;
-	BKInt      lastPulse;
-	BKInt      origPhase, origWrapCount;
+	BKFrame    deltas [BK_UNIT_EDGES_SIZE];
 
-	origPhase = unit -> phase.phase;
-	origWrapCount = unit -> phase.wrapCount;
+	for (BKInt i = 0; i < unit -> ctx -> numChannels; i ++) {
+		volume = unit -> state -> volume [i];
 
+		if (!volume) {
+			continue;
+		}
+
+		channel   = & unit -> channels [i];
+		lastPulse = unit -> state -> lastPulse [i];
+
+		for (BKUInt j = 0; j < edges -> count; j ++) {
+			delta = (edges -> pulses [j] * volume) >> BK_VOLUME_SHIFT;
+			deltas [j] = delta - lastPulse;
+			lastPulse = delta;
+		}
+
+		BKBufferAddPulses (channel, edges -> times, deltas, edges -> count);
+
+		unit -> state -> lastPulse [i] = lastPulse;
+	}
+}
+
+/**
+ * Check if unit is not muted and has volume in any channel
+ */
+static BKInt BKUnitIsAudible (BKUnit const * unit)
+{
 	if (unit -> mute) {
-		return time;
+		return 0;
 	}
 
-	// update each channel
 	for (BKInt i = 0; i < unit -> ctx -> numChannels; i ++) {
-		volume = unit -> volume [i];
-
-		if (!volume) {
-			continue;
+		if (unit -> state -> volume [i]) {
+			return 1;
 		}
+	}
+
+	return 0;
+}
+
+/**
+ * Fills buffer with waveform to specified time
+ *
+ * Edges are generated once and then scattered into all channels
+ */
+static BKFUInt20 BKUnitRunWaveform (BKUnit * unit, BKFUInt20 endTime)
+{
+	BKFUInt20   time = 0;
+	BKUnitEdges edges;
 
-		channel   = & unit -> ctx -> channels [i];
-		lastPulse = unit -> lastPulse [i];
-		time      = unit -> time;
+	// silent in all channels
+	if (!BKUnitIsAudible (unit)) {
+		return time;
+	}
 
-		unit -> phase.phase = origPhase;
-		unit -> phase.wrapCount = origWrapCount;
+	time = unit -> state -> time;
 
+	while (time < endTime) {
 		switch (unit -> waveform) {
 			case BK_SQUARE: {
-				time = BKUnitRunWaveformSquare (unit, channel, &lastPulse, volume, time, endTime);
+				time = BKUnitEdgesSquare (unit, & edges, time, endTime);
 				break;
 			}
 			case BK_TRIANGLE: {
-				time = BKUnitRunWaveformTriangle (unit, channel, &lastPulse, volume, time, endTime);
+				time = BKUnitEdgesTriangle (unit, & edges, time, endTime);
 				break;
 			}
 			case BK_NOISE: {
-				time = BKUnitRunWaveformNoise (unit, channel, &lastPulse, volume, time, endTime);
+				time = BKUnitEdgesNoise (unit, & edges, time, endTime);
 				break;
 			}
 			case BK_SAWTOOTH: {
-				time = BKUnitRunWaveformSawtooth (unit, channel, &lastPulse, volume, time, endTime);
+				time = BKUnitEdgesSawtooth (unit, & edges, time, endTime);
 				break;
 			}
 			case BK_SINE: {
-				time = BKUnitRunWaveformSine (unit, channel, &lastPulse, volume, time, endTime);
+				time = BKUnitEdgesSine (unit, & edges, time, endTime);
 				break;
 			}
 			case BK_CUSTOM: {
-				time = BKUnitRunWaveformCustom (unit, channel, &lastPulse, volume, time, endTime);
+				time = BKUnitEdgesCustom (unit, & edges, time, endTime);
 				break;
 			}
 		}
 
-		unit -> lastPulse [i] = lastPulse;
+		BKUnitScatterEdges (unit, & edges);
+	}
+
+	return time;
+}
+
+/**
+ * Advance waveform phase to specified time without writing pulses
+ *
+ * Results in the same phase as `BKUnitRunWaveform`
+ */
+static BKFUInt20 BKUnitSkipWaveform (BKUnit * unit, BKFUInt20 endTime)
+{
+	BKFUInt20 time = 0;
+	BKUInt    steps;
+	BKUInt    phase;
+	BKUInt    wrap;
+	BKInt     pulse, wrapCount;
+
+	if (!BKUnitIsAudible (unit)) {
+		return time;
+	}
+
+	time = unit -> state -> time;
+
+	if (time >= endTime) {
+		return time;
+	}
+
+	steps = (endTime - time - 1) / unit -> state -> period + 1;
+	time += steps * unit -> state -> period;
+	phase = unit -> state -> phase.phase;
+
+	switch (unit -> waveform) {
+		case BK_SQUARE: {
+			phase = (phase + steps) & (BK_SQUARE_PHASES - 1);
+			break;
+		}
+		case BK_TRIANGLE: {
+			phase = (phase + steps) & (BK_TRIANGLE_PHASES - 1);
+			break;
+		}
+		case BK_SAWTOOTH: {
+			if (phase >= BK_SAWTOOTH_PHASES) {
+				phase = 0;
+				steps --;
+			}
+
+			phase = (phase + steps) % BK_SAWTOOTH_PHASES;
+			break;
+		}
+		case BK_SINE: {
+			phase = (phase + steps) & (BK_SINE_PHASES - 1);
+			break;
+		}
+		case BK_NOISE: {
+			wrap = unit -> state -> phase.wrap;
+			wrapCount = unit -> state -> phase.wrapCount;
+
+			if (!phase) {
+				phase = 0x4a41;
+			}
+
+			for (; steps; steps --) {
+				if (wrap) {
+					if (-- wrapCount <= 0) {
+						wrapCount = wrap;
+						phase = 0x4a41;
+					}
+				}
+
+				pulse = ((phase >> 0) ^ (phase >> 2) ^ (phase >> 3) ^ (phase >> 5)) & 1;
+				phase = (phase >> 1) | (pulse << 15);
+			}
+
+			unit -> state -> phase.wrapCount = wrapCount;
+			break;
+		}
+		case BK_CUSTOM: {
+			wrap = unit -> state -> phase.wrap;
+			wrapCount = unit -> state -> phase.wrapCount;
+
+			for (; steps; steps --) {
+				if (wrap) {
+					if (-- wrapCount <= 0) {
+						wrapCount = wrap;
+						phase = 0;
+					}
+				}
+
+				if (++ phase >= unit -> state -> phase.count) {
+					phase = 0;
+				}
+			}
+
+			unit -> state -> phase.wrapCount = wrapCount;
+			break;
+		}
 	}
 
+	unit -> state -> phase.phase = phase;
+
 	return time;
 }
 
@@ -1026,19 +1346,19 @@ static BKInt BKUnitWrapSamplePhase (BKUnit * unit, BKInt min, BKInt max)
 	BKInt length   = max - min;
 
 	// reset if phase exceeds end
-	if ((BKInt) unit -> phase.phase >= max) {
+	if ((BKInt) unit -> state -> phase.phase >= max) {
 		// phase %= length
-		while ((BKInt) unit -> phase.phase >= max) {
-			unit -> phase.phase -= length;
+		while ((BKInt) unit -> state -> phase.phase >= max) {
+			unit -> state -> phase.phase -= length;
 		}
 
 		resetDir = 1;
 	}
 	// reset if phase exceeds end (reversed)
-	else if ((BKInt) unit -> phase.phase < min) {
+	else if ((BKInt) unit -> state -> phase.phase < min) {
 		// phase %= length
-		while ((BKInt) unit -> phase.phase < min) {
-			unit -> phase.phase += length;
+		while ((BKInt) unit -> state -> phase.phase < min) {
+			unit -> state -> phase.phase += length;
 		}
 
 		resetDir = -1;
@@ -1073,10 +1393,10 @@ static BKInt BKUnitResetSample (BKUnit * unit)
 		}
 		case BK_PALINDROME: {
 			if (resetDir == 1) {
-				unit -> phase.phase = unit -> sample.length - unit -> phase.phase - 1;
+				unit -> state -> phase.phase = unit -> sample.length - unit -> state -> phase.phase - 1;
 			}
 			else if (resetDir == -1) {
-				unit -> phase.phase = unit -> sample.length - unit -> phase.phase;
+				unit -> state -> phase.phase = unit -> sample.length - unit -> state -> phase.phase;
 			}
 			mode = -resetDir;
 			break;
@@ -1108,9 +1428,10 @@ static BKInt BKUnitResetSample (BKUnit * unit)
 
 /**
  * Fills buffer with sample to specified time
+ * If `skip` is set, the phase is advanced without writing pulses
  * Calls sample callback if sample has ended and asks if it should be repeated
  */
-static BKFUInt20 BKUnitRunSample (BKUnit * unit, BKFUInt20 endTime)
+static BKFUInt20 BKUnitRunSample (BKUnit * unit, BKFUInt20 endTime, BKInt skip)
 {
 	BKFInt20   time, lastTime;
 	BKInt      volume;
@@ -1131,18 +1452,18 @@ static BKFUInt20 BKUnitRunSample (BKUnit * unit, BKFUInt20 endTime)
 
 	checkBounds = (unit -> object.flags & BKUnitFlagSampleSustainRange) && !(unit -> object.flags & BKUnitFlagRelease);
 
-	for (time = unit -> time; time < endTime; time += BK_FINT20_UNIT) {
-		frames = & unit -> sample.frames [unit -> phase.phase * unit -> sample.numChannels];
+	for (time = unit -> state -> time; time < endTime; time += BK_FINT20_UNIT) {
+		frames = & unit -> sample.frames [unit -> state -> phase.phase * unit -> sample.numChannels];
 
 		// update each channel
-		for (BKInt i = 0; i < unit -> ctx -> numChannels; i ++) {
-			channel = & unit -> ctx -> channels [i];
-			volume  = unit -> volume [i];
+		for (BKInt i = 0; i < unit -> ctx -> numChannels && !skip; i ++) {
+			channel = & unit -> channels [i];
+			volume  = unit -> state -> volume [i];
 			pulse   = frames [unit -> sample.numChannels == 1 ? 0 : i];
 			delta   = (pulse * volume) >> BK_VOLUME_SHIFT;
 
-			chanDelta = delta - unit -> lastPulse [i];
-			unit -> lastPulse [i] = delta;
+			chanDelta = delta - unit -> state -> lastPulse [i];
+			unit -> state -> lastPulse [i] = delta;
 
 			BKBufferAddPulse (channel, time + unit -> sample.timeFrac, chanDelta);
 		}
@@ -1150,11 +1471,11 @@ static BKFUInt20 BKUnitRunSample (BKUnit * unit, BKFUInt20 endTime)
 		// advance phase
 		lastTime = unit -> sample.timeFrac;
 		unit -> sample.timeFrac += unit -> sample.period; // may be negative
-		unit -> phase.phase += (unit -> sample.timeFrac >> BK_FINT20_SHIFT) - (lastTime >> BK_FINT20_SHIFT);
+		unit -> state -> phase.phase += (unit -> sample.timeFrac >> BK_FINT20_SHIFT) - (lastTime >> BK_FINT20_SHIFT);
 		unit -> sample.timeFrac &= BK_FINT20_FRAC;
 
 		// check phase boundary
-		if ((BKInt) unit -> phase.phase < 0 || (BKInt) unit -> phase.phase >= (BKInt) unit -> sample.length) {
+		if ((BKInt) unit -> state -> phase.phase < 0 || (BKInt) unit -> state -> phase.phase >= (BKInt) unit -> sample.length) {
 			if (BKUnitResetSample (unit) == 1) {
 				break;
 			}
@@ -1163,13 +1484,13 @@ static BKFUInt20 BKUnitRunSample (BKUnit * unit, BKFUInt20 endTime)
 		// check for sustain range boundary
 		if (checkBounds) {
 			if (unit -> sample.period > 0) {
-				if ((BKInt) unit -> phase.phase >= (BKInt) unit -> sample.sustainEnd) {
-					unit -> phase.phase = unit -> sample.sustainOffset;
+				if ((BKInt) unit -> state -> phase.phase >= (BKInt) unit -> sample.sustainEnd) {
+					unit -> state -> phase.phase = unit -> sample.sustainOffset;
 				}
 			}
 			else {
-				if ((BKInt) unit -> phase.phase < (BKInt) unit -> sample.sustainOffset) {
-					unit -> phase.phase = unit -> sample.sustainEnd - 1;
+				if ((BKInt) unit -> state -> phase.phase < (BKInt) unit -> sample.sustainOffset) {
+					unit -> state -> phase.phase = unit -> sample.sustainEnd - 1;
 				}
 			}
 		}
@@ -1181,10 +1502,26 @@ static BKFUInt20 BKUnitRunSample (BKUnit * unit, BKFUInt20 endTime)
 BKInt BKUnitRun (BKUnit * unit, BKFUInt20 endTime)
 {
 	BKContext * ctx  = unit -> ctx;
-	BKFUInt20   time = unit -> time;
+	BKFUInt20   time = unit -> state -> time;
 	BKBuffer  * channel;
 
-	if (unit -> period) {
+	// advance phase only; pulses and buffers are left untouched
+	if (ctx -> flags & BK_CONTEXT_FLAG_SEEK) {
+		if (unit -> state -> period) {
+			if (unit -> waveform == BK_SAMPLE) {
+				time = BKUnitRunSample (unit, endTime, 1);
+			}
+			else {
+				time = BKUnitSkipWaveform (unit, endTime);
+			}
+		}
+
+		unit -> state -> time = time < endTime ? endTime : time;
+
+		return 0;
+	}
+
+	if (unit -> state -> period) {
 		switch (unit -> waveform) {
 			case BK_SQUARE:
 			case BK_TRIANGLE:
@@ -1196,7 +1533,7 @@ BKInt BKUnitRun (BKUnit * unit, BKFUInt20 endTime)
 				break;
 			}
 			case BK_SAMPLE: {
-				time = BKUnitRunSample (unit, endTime);
+				time = BKUnitRunSample (unit, endTime, 0);
 				break;
 			}
 		}
@@ -1208,11 +1545,11 @@ BKInt BKUnitRun (BKUnit * unit, BKFUInt20 endTime)
 
 	// advance buffer capacity
 	for (BKInt i = 0; i < ctx -> numChannels; i ++) {
-		channel = & ctx -> channels [i];
+		channel = & unit -> channels [i];
 		BKBufferEnd (channel, time);
 	}
 
-	unit -> time = time;
+	unit -> state -> time = time;
 
 	return 0;
 }
@@ -1222,7 +1559,70 @@ BKInt BKUnitRun (BKUnit * unit, BKFUInt20 endTime)
  */
 void BKUnitEnd (BKUnit * unit, BKFUInt20 time)
 {
-	unit -> time -= time;
+	unit -> state -> time -= time;
+}
+
+BKSize BKUnitCopyState (BKUnit * unit, void * state, BKInt restore)
+{
+	BKUnitState unitState;
+
+	if (state == NULL) {
+		return sizeof (unitState);
+	}
+
+	// `state` may not be aligned
+	if (restore) {
+		memcpy (& unitState, state, sizeof (unitState));
+
+		unit -> object.flags    = (unit -> object.flags & (BKObjectFlagMask | BKUnitFlagSleeping)) | unitState.flags;
+		unit -> state -> time   = unitState.time;
+		unit -> state -> period = unitState.period;
+		unit -> dutyCycle       = unitState.dutyCycle;
+		unit -> mute            = unitState.mute;
+		memcpy (unit -> state -> lastPulse, unitState.lastPulse, sizeof (unit -> state -> lastPulse));
+		memcpy (unit -> state -> volume, unitState.volume, sizeof (unit -> state -> volume));
+
+		unit -> state -> phase.phase     = unitState.phase;
+		unit -> state -> phase.wrap      = unitState.wrap;
+		unit -> state -> phase.wrapCount = unitState.wrapCount;
+
+		unit -> sample.offset        = unitState.offset;
+		unit -> sample.end           = unitState.end;
+		unit -> sample.repeatMode    = unitState.repeatMode;
+		unit -> sample.repeatCount   = unitState.repeatCount;
+		unit -> sample.sustainOffset = unitState.sustainOffset;
+		unit -> sample.sustainEnd    = unitState.sustainEnd;
+		unit -> sample.timeFrac      = unitState.timeFrac;
+		unit -> sample.period        = unitState.samplePeriod;
+	}
+	else {
+		memset (& unitState, 0, sizeof (unitState));
+
+		unitState.flags     = unit -> object.flags & BKObjectFlagUsableMask & ~BKUnitFlagSleeping;
+		unitState.time      = (unit -> object.flags & BKUnitFlagSleeping) ? unit -> ctx -> unitTime : unit -> state -> time;
+		unitState.period    = unit -> state -> period;
+		unitState.dutyCycle = unit -> dutyCycle;
+		unitState.mute      = unit -> mute;
+		memcpy (unitState.lastPulse, unit -> state -> lastPulse, sizeof (unit -> state -> lastPulse));
+		memcpy (unitState.volume, unit -> state -> volume, sizeof (unit -> state -> volume));
+
+		unitState.phase     = unit -> state -> phase.phase;
+		unitState.wrap      = unit -> state -> phase.wrap;
+		unitState.wrapCount = unit -> state -> phase.wrapCount;
+
+		unitState.offset        = unit -> sample.offset;
+		unitState.end           = unit -> sample.end;
+		unitState.repeatMode    = unit -> sample.repeatMode;
+		unitState.repeatCount   = unit -> sample.repeatCount;
+		unitState.sustainOffset = unit -> sample.sustainOffset;
+		unitState.sustainEnd    = unit -> sample.sustainEnd;
+		unitState.timeFrac      = unit -> sample.timeFrac;
+		unitState.samplePeriod  = unit -> sample.period;
+
+		memcpy (state, & unitState, sizeof (unitState));
+	}
+
+	return sizeof (unitState);
 }
 
 void BKUnitClear (BKUnit * unit)
@@ -1230,9 +1630,9 @@ void BKUnitClear (BKUnit * unit)
 	BKUnitSetData (unit, BK_WAVEFORM, NULL);
 	BKUnitSetData (unit, BK_SAMPLE, NULL);
 
-	unit -> object.flags    &= BKUnitFlagsClearMask;
-	unit -> phase.wrap      = 0;
-	unit -> phase.wrapCount = 0;
+	unit -> object.flags            &= BKUnitFlagsClearMask;
+	unit -> state -> phase.wrap      = 0;
+	unit -> state -> phase.wrapCount = 0;
 
 	unit -> sample.offset                     = 0;
 	unit -> sample.end                        = 0;
@@ -1258,13 +1658,13 @@ void BKUnitReset (BKUnit * unit)
 {
 	BKUnitClear (unit);
 
-	unit -> period      = 0;
-	unit -> waveform    = 0;
-	unit -> phase.phase = 0;
-	unit -> time = 0;
+	unit -> state -> period      = 0;
+	unit -> waveform             = 0;
+	unit -> state -> phase.phase = 0;
+	unit -> state -> time        = 0;
 
 	for (BKInt i = 0; i < BK_MAX_CHANNELS; i ++)
-		unit -> lastPulse [i] = 0;
+		unit -> state -> lastPulse [i] = 0;
 }
 
 static BKInt BKUnitSetPtrSize (BKUnit * unit, BKEnum attr, void * ptr, BKSize size)
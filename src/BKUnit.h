@@ -32,10 +32,12 @@ enum
 	BKUnitFlagSampleSustainRange = 1 << 0, // has `BK_SAMPLE_SUSTAIN_RANGE` set
 	BKUnitFlagSampleSustainJump  = 1 << 1, // should jump immediately to release phase
 	BKUnitFlagRelease            = 1 << 2, // set release phase
+	BKUnitFlagSleeping           = 1 << 3, // attached but not run
 	BKUnitFlagsClearMask         = ~7,
 };
 
 typedef struct BKUnitFuncs BKUnitFuncs;
+typedef struct BKUnitRunState BKUnitRunState;
 
 /**
  * Units are attached to a context and generate samples with a specified
@@ -48,41 +50,64 @@ typedef BKInt (* BKUnitRunFunc)   (void * unit, BKFUInt20 endTime);
 typedef BKInt (* BKUnitEndFunc)   (void * unit, BKFUInt20 time);
 typedef void  (* BKUnitResetFunc) (void * unit);
 
+/**
+ * Copy run state of unit into `state` or restore it from `state` if `restore`
+ * is set. Returns the state size; only the size is returned if `state` is NULL
+ */
+typedef BKSize (* BKUnitCopyStateFunc) (void * unit, void * state, BKInt restore);
+
+/**
+ * State which is changed by running the unit
+ *
+ * The states of awake units are stored densely in `unitStates` of the context
+ */
+struct BKUnitRunState
+{
+	// time
+	BKFUInt20 time;
+	BKFUInt20 period;
+
+	// phase
+	struct {
+		BKUInt phase;  // contains noise seed and sample offset
+		BKUInt wrap;
+		BKInt  wrapCount;
+		BKUInt count;
+	} phase;
+
+	// pulses
+	BKInt volume [BK_MAX_CHANNELS];
+	BKInt lastPulse [BK_MAX_CHANNELS];
+};
+
 struct BKUnit
 {
 	BKObject object;
 
 	// context
 	BKContext     * ctx;
+	BKBuffer      * channels; // channel buffers written to
 	BKUnitRunFunc   run;
 	BKUnitEndFunc   end;
 	BKUnitResetFunc reset;
+	BKUnitCopyStateFunc copyState;
 
 	// linking
 	BKUnit * prevUnit;
 	BKUnit * nextUnit;
+	BKUInt   unitIndex; // index in `units` of context if not sleeping
 
-	// time
-	BKFUInt20 time;
-	BKFUInt20 period;
-	BKInt     lastPulse [BK_MAX_CHANNELS];
+	// run state
+	BKUnitRunState * state;    // points into `unitStates` of context if not sleeping
+	BKUnitRunState   ownState; // used while detached or sleeping
 
 	// waveform
 	BKEnum waveform;
 	BKUInt dutyCycle;
 
 	// volume
-	BKInt volume [BK_MAX_CHANNELS];
 	BKInt mute;
 
-	// phase
-	struct {
-		BKUInt phase;  // contains noise seed and sample offset
-		BKUInt wrap;
-		BKInt  wrapCount;
-		BKUInt count;
-	} phase;
-
 	// samples
 	struct {
 		BKDataState dataState;
@@ -115,12 +140,16 @@ extern BKInt BKUnitInit (BKUnit * unit, BKEnum waveform);
  * Attach to context
  *
  * Errors:
- * BK_INVALID_STATE if already attached to a context
+ * BK_INVALID_STATE if already attached to a context or if called from a
+ * sample callback while the context runs units with multiple threads
+ * BK_ALLOCATION_ERROR if memory could not be allocated
  */
 extern BKInt BKUnitAttach (BKUnit * unit, BKContext * ctx);
 
 /**
  * Detach from context
+ * Ignored if called from a sample callback while the context runs units with
+ * multiple threads
  */
 extern void BKUnitDetach (BKUnit * unit);
 
@@ -34,6 +34,23 @@ extern BKInt BKUnitRun (BKUnit * unit, BKFUInt20 endTime);
  */
 extern void BKUnitEnd (BKUnit * unit, BKFUInt20 time);
 
+/**
+ * Remove attached unit from the units which are run by the context
+ *
+ * A sleeping unit neither runs nor advances its time. It must not be audible
+ * so that its phase would not have been advanced anyway
+ */
+extern void BKUnitSleep (BKUnit * unit);
+
+/**
+ * Run sleeping unit again from the time the context units have been run to
+ *
+ * Errors:
+ * BK_INVALID_STATE if the context runs units with multiple threads
+ * BK_ALLOCATION_ERROR if memory could not be allocated
+ */
+extern BKInt BKUnitWake (BKUnit * unit);
+
 /**
  * Reset unit values and buffer state
  */
@@ -44,6 +61,11 @@ extern void BKUnitReset (BKUnit * unit);
  */
 extern void BKUnitClear (BKUnit * unit);
 
+/**
+ * Copy or restore unit run state
+ */
+extern BKSize BKUnitCopyState (BKUnit * unit, void * state, BKInt restore);
+
 /*
  */
 extern BKInt BKUnitSampleDataStateCallback (BKEnum event, BKUnit * unit);
@@ -52,4 +74,83 @@ extern BKInt BKUnitSampleDataStateCallback (BKEnum event, BKUnit * unit);
  */
 extern void BKUnitDisposeObject (BKUnit * unit);
 
+/**
+ * Set volume of each channel of the context to `volume` multiplied by the
+ * channel's gain
+ * Gains have a unity of `1 << BK_VOLUME_SHIFT`
+ * Unchanged volumes are not written
+ */
+BK_INLINE void BKUnitSetVolumes (BKUnit * unit, BKInt volume, BKInt const gains []);
+
+/**
+ * Same as setting BK_PERIOD but only written if changed
+ */
+BK_INLINE void BKUnitSetPeriod (BKUnit * unit, BKInt period);
+
+/**
+ * Same as setting BK_SAMPLE_PERIOD but only written if changed
+ */
+BK_INLINE void BKUnitSetSamplePeriod (BKUnit * unit, BKInt period);
+
+/**
+ * Same as setting BK_DUTY_CYCLE
+ */
+BK_INLINE void BKUnitSetDutyCycle (BKUnit * unit, BKInt dutyCycle);
+
+
+BK_INLINE void BKUnitSetVolumes (BKUnit * unit, BKInt volume, BKInt const gains [])
+{
+	BKInt numChannels = unit -> ctx ? unit -> ctx -> numChannels : BK_MAX_CHANNELS;
+	BKInt channelVolume;
+
+	volume = BKClamp (volume, 0, BK_MAX_VOLUME);
+
+	for (BKInt i = 0; i < numChannels; i ++) {
+		channelVolume = (volume * gains [i]) >> BK_VOLUME_SHIFT;
+
+		if (unit -> state -> volume [i] != channelVolume) {
+			unit -> state -> volume [i] = channelVolume;
+		}
+	}
+}
+
+BK_INLINE void BKUnitSetPeriod (BKUnit * unit, BKInt period)
+{
+	period = BKMax (BKAbs (period), BK_MIN_PERIOD);
+
+	if (unit -> state -> period != period) {
+		unit -> state -> period = period;
+	}
+}
+
+BK_INLINE void BKUnitSetSamplePeriod (BKUnit * unit, BKInt period)
+{
+	period = BKAbs (period);
+	period = BKClamp (period, BK_MIN_SAMPLE_PERIOD, BK_MAX_SAMPLE_PERIOD);
+
+	// reverse if negative
+	if (unit -> sample.period < 0) {
+		period = -period;
+	}
+
+	if (unit -> sample.period != period) {
+		unit -> sample.period = period;
+	}
+}
+
+BK_INLINE void BKUnitSetDutyCycle (BKUnit * unit, BKInt dutyCycle)
+{
+	dutyCycle = BKClamp (dutyCycle, BK_MIN_DUTY_CYCLE, BK_MAX_DUTY_CYCLE);
+
+	if (unit -> dutyCycle != dutyCycle) {
+		if (unit -> waveform == BK_SQUARE) {
+			// reduce clicking noise
+			if (dutyCycle > unit -> dutyCycle && unit -> state -> phase.phase < dutyCycle)
+				unit -> state -> phase.phase = 0;
+		}
+
+		unit -> dutyCycle = dutyCycle;
+	}
+}
+
 #endif /* ! _BK_UNIT_INTERN_H_ */
@@ -0,0 +1,389 @@
+/*
+ * Copyright (c) 2012-2016 Simon Schoenenberger
+ * http://blipkit.audio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "BKVoicePool.h"
+#include "BKTone.h"
+#include "BKContext_internal.h"
+#include "BKTrack_internal.h"
+
+extern BKClass BKVoicePoolClass;
+
+/**
+ * Tick active voices and park voices which have been released and muted
+ */
+static BKEnum BKVoicePoolTick (BKCallbackInfo * info, BKVoicePool * pool)
+{
+	BKVoice * voice;
+
+	for (BKUInt i = 0; i < pool -> numVoices; i ++) {
+		voice = & pool -> voices [i];
+
+		if (!voice -> active)
+			continue;
+
+		BKTrackTick (info, & voice -> track);
+
+		if (voice -> note == -1 && voice -> track.curNote == -1 && voice -> track.unit.mute) {
+			BKTrackDetach (& voice -> track);
+			voice -> active = 0;
+			pool -> numActiveVoices --;
+		}
+	}
+
+	return 0;
+}
+
+static BKInt BKVoicePoolInitGeneric (BKVoicePool * pool, BKUInt numVoices, BKEnum waveform)
+{
+	BKCallback callback;
+
+	if (numVoices < 1 || numVoices > BK_MAX_VOICES) {
+		return BK_INVALID_VALUE;
+	}
+
+	pool -> voices = calloc (numVoices, sizeof (BKVoice));
+
+	if (pool -> voices == NULL) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	for (BKUInt i = 0; i < numVoices; i ++) {
+		if (BKTrackInit (& pool -> voices [i].track, waveform) < 0) {
+			return BK_ALLOCATION_ERROR;
+		}
+
+		pool -> voices [i].note = -1;
+		pool -> numVoices ++;
+	}
+
+	pool -> stealing = BK_STEAL_OLDEST;
+
+	callback.func     = (BKCallbackFunc) BKVoicePoolTick;
+	callback.userInfo = pool;
+
+	BKDividerInit (& pool -> divider, 1, & callback);
+
+	return 0;
+}
+
+BKInt BKVoicePoolInit (BKVoicePool * pool, BKUInt numVoices, BKEnum waveform)
+{
+	BKInt res;
+
+	if (BKObjectInit (pool, & BKVoicePoolClass, sizeof (*pool)) < 0) {
+		return -1;
+	}
+
+	if ((res = BKVoicePoolInitGeneric (pool, numVoices, waveform)) != 0) {
+		BKDispose (pool);
+		return res;
+	}
+
+	return 0;
+}
+
+BKInt BKVoicePoolAlloc (BKVoicePool ** outPool, BKUInt numVoices, BKEnum waveform)
+{
+	BKInt res;
+
+	if (BKObjectAlloc ((void **) outPool, & BKVoicePoolClass, 0) < 0) {
+		return -1;
+	}
+
+	if ((res = BKVoicePoolInitGeneric (*outPool, numVoices, waveform)) != 0) {
+		BKDispose (*outPool);
+		*outPool = NULL;
+		return res;
+	}
+
+	return 0;
+}
+
+static void BKVoicePoolDisposeObject (BKVoicePool * pool)
+{
+	BKVoicePoolDetach (pool);
+
+	for (BKUInt i = 0; i < pool -> numVoices; i ++)
+		BKDispose (& pool -> voices [i].track);
+
+	free (pool -> voices);
+}
+
+BKInt BKVoicePoolAttach (BKVoicePool * pool, BKContext * ctx)
+{
+	BKInt res;
+
+	if (pool -> ctx) {
+		return BK_INVALID_STATE;
+	}
+
+	res = BKContextAttachDivider (ctx, & pool -> divider, BK_CLOCK_TYPE_EFFECT);
+
+	if (res != 0) {
+		return res;
+	}
+
+	pool -> ctx = ctx;
+
+	return 0;
+}
+
+void BKVoicePoolDetach (BKVoicePool * pool)
+{
+	BKVoice * voice;
+
+	if (pool -> ctx == NULL) {
+		return;
+	}
+
+	for (BKUInt i = 0; i < pool -> numVoices; i ++) {
+		voice = & pool -> voices [i];
+
+		if (voice -> active) {
+			BKSetAttr (& voice -> track, BK_NOTE, BK_NOTE_MUTE);
+			BKTrackDetach (& voice -> track);
+		}
+
+		voice -> active = 0;
+		voice -> note   = -1;
+	}
+
+	BKDividerDetach (& pool -> divider);
+
+	pool -> numActiveVoices = 0;
+	pool -> ctx = NULL;
+}
+
+/**
+ * Get summed volume of all channels
+ */
+static BKInt BKVoiceGetVolume (BKVoicePool const * pool, BKVoice const * voice)
+{
+	BKInt volume = 0;
+
+	if (voice -> track.unit.mute) {
+		return 0;
+	}
+
+	for (BKUInt i = 0; i < pool -> ctx -> numChannels; i ++)
+		volume += voice -> track.unit.state -> volume [i];
+
+	return volume;
+}
+
+/**
+ * Check if voice `a` should be stolen before voice `b`
+ */
+static BKInt BKVoicePoolShouldSteal (BKVoicePool const * pool, BKVoice const * a, BKVoice const * b)
+{
+	BKInt volumeA, volumeB;
+
+	// prefer released voices
+	if ((a -> note == -1) != (b -> note == -1)) {
+		return a -> note == -1;
+	}
+
+	if (pool -> stealing == BK_STEAL_QUIETEST) {
+		volumeA = BKVoiceGetVolume (pool, a);
+		volumeB = BKVoiceGetVolume (pool, b);
+
+		if (volumeA != volumeB) {
+			return volumeA < volumeB;
+		}
+	}
+
+	// wraps around after 2^32 notes
+	return (BKInt) (a -> age - b -> age) < 0;
+}
+
+/**
+ * Get parked voice or voice to steal
+ */
+static BKVoice * BKVoicePoolNextVoice (BKVoicePool * pool)
+{
+	BKVoice * voice;
+	BKVoice * stolen = NULL;
+
+	for (BKUInt i = 0; i < pool -> numVoices; i ++) {
+		voice = & pool -> voices [i];
+
+		if (!voice -> active) {
+			return voice;
+		}
+
+		if (stolen == NULL || BKVoicePoolShouldSteal (pool, voice, stolen)) {
+			stolen = voice;
+		}
+	}
+
+	return stolen;
+}
+
+BKInt BKVoicePoolNoteOn (BKVoicePool * pool, BKInt note)
+{
+	BKInt     res;
+	BKVoice * voice;
+
+	if (pool -> ctx == NULL) {
+		return BK_INVALID_STATE;
+	}
+
+	if (note < 0) {
+		return BK_INVALID_VALUE;
+	}
+
+	voice = BKVoicePoolNextVoice (pool);
+
+	if (voice -> active) {
+		// begin new attack
+		BKSetAttr (& voice -> track, BK_NOTE, BK_NOTE_MUTE);
+	}
+	else {
+		res = BKTrackAttachUnit (& voice -> track, pool -> ctx);
+
+		if (res != 0) {
+			return res;
+		}
+
+		voice -> active = 1;
+		pool -> numActiveVoices ++;
+	}
+
+	voice -> note = note;
+	voice -> age  = ++ pool -> age;
+
+	BKSetAttr (& voice -> track, BK_NOTE, note);
+
+	return (BKInt) (voice - pool -> voices);
+}
+
+void BKVoicePoolNoteOff (BKVoicePool * pool, BKInt note)
+{
+	BKVoice * voice;
+
+	for (BKUInt i = 0; i < pool -> numVoices; i ++) {
+		voice = & pool -> voices [i];
+
+		if (voice -> active && voice -> note == note) {
+			voice -> note = -1;
+			BKSetAttr (& voice -> track, BK_NOTE, BK_NOTE_RELEASE);
+		}
+	}
+}
+
+BKInt BKVoicePoolSetAttr (BKVoicePool * pool, BKEnum attr, BKInt value)
+{
+	BKInt res;
+
+	switch (attr) {
+		case BK_VOICE_STEALING: {
+			if (value != BK_STEAL_OLDEST && value != BK_STEAL_QUIETEST) {
+				return BK_INVALID_VALUE;
+			}
+
+			pool -> stealing = value;
+			return 0;
+			break;
+		}
+		case BK_NUM_VOICES:
+		case BK_NUM_ACTIVE_VOICES: {
+			return BK_INVALID_ATTRIBUTE;
+			break;
+		}
+		case BK_NOTE: {
+			if (value >= 0) {
+				res = BKVoicePoolNoteOn (pool, value);
+				return res < 0 ? res : 0;
+			}
+
+			for (BKUInt i = 0; i < pool -> numVoices; i ++) {
+				if (pool -> voices [i].active) {
+					pool -> voices [i].note = -1;
+					BKSetAttr (& pool -> voices [i].track, BK_NOTE, value);
+				}
+			}
+
+			return 0;
+			break;
+		}
+	}
+
+	for (BKUInt i = 0; i < pool -> numVoices; i ++) {
+		if ((res = BKSetAttr (& pool -> voices [i].track, attr, value)) != 0)
+			return res;
+	}
+
+	return 0;
+}
+
+BKInt BKVoicePoolGetAttr (BKVoicePool const * pool, BKEnum attr, BKInt * outValue)
+{
+	switch (attr) {
+		case BK_NUM_VOICES: {
+			* outValue = pool -> numVoices;
+			break;
+		}
+		case BK_NUM_ACTIVE_VOICES: {
+			* outValue = pool -> numActiveVoices;
+			break;
+		}
+		case BK_VOICE_STEALING: {
+			* outValue = pool -> stealing;
+			break;
+		}
+		default: {
+			return BKGetAttr (& pool -> voices [0].track, attr, outValue);
+			break;
+		}
+	}
+
+	return 0;
+}
+
+BKInt BKVoicePoolSetPtr (BKVoicePool * pool, BKEnum attr, void * ptr, BKSize size)
+{
+	BKInt res;
+
+	for (BKUInt i = 0; i < pool -> numVoices; i ++) {
+		if ((res = BKSetPtr (& pool -> voices [i].track, attr, ptr, size)) != 0)
+			return res;
+	}
+
+	return 0;
+}
+
+BKInt BKVoicePoolGetPtr (BKVoicePool const * pool, BKEnum attr, void * outPtr, BKSize size)
+{
+	return BKGetPtr (& pool -> voices [0].track, attr, outPtr, size);
+}
+
+BKClass BKVoicePoolClass =
+{
+	.instanceSize = sizeof (BKVoicePool),
+	.dispose      = (BKDisposeFunc) BKVoicePoolDisposeObject,
+	.setAttr      = (BKSetAttrFunc) BKVoicePoolSetAttr,
+	.getAttr      = (BKGetAttrFunc) BKVoicePoolGetAttr,
+	.setPtr       = (BKSetPtrFunc)  BKVoicePoolSetPtr,
+	.getPtr       = (BKGetPtrFunc)  BKVoicePoolGetPtr,
+};
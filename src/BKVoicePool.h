@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2012-2016 Simon Schoenenberger
+ * http://blipkit.audio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * @file
+ * A fixed set of tracks played as polyphonic voices
+ *
+ * Voices are attached to the context when a note is played and detached
+ * again when their note has been released and muted. All voices are ticked by
+ * a single divider of the pool, so parked voices neither run nor tick.
+ */
+
+#ifndef _BK_VOICE_POOL_H_
+#define _BK_VOICE_POOL_H_
+
+#include "BKTrack.h"
+
+#define BK_MAX_VOICES 256
+
+typedef struct BKVoice     BKVoice;
+typedef struct BKVoicePool BKVoicePool;
+
+struct BKVoice
+{
+	BKTrack track;
+	BKInt   note;   // note played or -1 if released
+	BKUInt  age;    // pool age at last note on
+	BKInt   active; // attached to context
+};
+
+struct BKVoicePool
+{
+	BKObject    object;
+	BKContext * ctx;
+	BKDivider   divider;   // ticks active voices
+	BKEnum      stealing;  // BK_STEAL_OLDEST or BK_STEAL_QUIETEST
+	BKUInt      age;       // incremented with each note on
+	BKUInt      numVoices;
+	BKUInt      numActiveVoices;
+	BKVoice   * voices;
+};
+
+/**
+ * Initialize voice pool with `numVoices` tracks of waveform `waveform`
+ *
+ * Errors:
+ * BK_INVALID_VALUE if `numVoices` is 0 or greater than BK_MAX_VOICES
+ * BK_ALLOCATION_ERROR if memory could not be allocated
+ */
+extern BKInt BKVoicePoolInit (BKVoicePool * pool, BKUInt numVoices, BKEnum waveform);
+
+/**
+ * Allocate voice pool
+ */
+extern BKInt BKVoicePoolAlloc (BKVoicePool ** outPool, BKUInt numVoices, BKEnum waveform);
+
+/**
+ * Attach to context
+ *
+ * Errors:
+ * BK_INVALID_STATE if already attached to a context
+ */
+extern BKInt BKVoicePoolAttach (BKVoicePool * pool, BKContext * ctx);
+
+/**
+ * Detach from context and mute all voices
+ */
+extern void BKVoicePoolDetach (BKVoicePool * pool);
+
+/**
+ * Play note on a free voice and return its index
+ * If all voices are active, a voice is stolen. Released voices are stolen
+ * before voices still holding their note
+ *
+ * Errors:
+ * BK_INVALID_STATE if not attached to a context
+ */
+extern BKInt BKVoicePoolNoteOn (BKVoicePool * pool, BKInt note);
+
+/**
+ * Release all voices playing `note`
+ */
+extern void BKVoicePoolNoteOff (BKVoicePool * pool, BKInt note);
+
+/**
+ * Set attribute
+ *
+ * BK_VOICE_STEALING
+ *   Voice to steal when all voices are active: BK_STEAL_OLDEST or
+ *   BK_STEAL_QUIETEST
+ *   Default is BK_STEAL_OLDEST
+ * BK_NOTE
+ *   A note value is played with `BKVoicePoolNoteOn`
+ *   BK_NOTE_RELEASE and BK_NOTE_MUTE are set on all voices
+ *
+ * All other attributes are set on every voice
+ */
+extern BKInt BKVoicePoolSetAttr (BKVoicePool * pool, BKEnum attr, BKInt value);
+
+/**
+ * Get attribute
+ *
+ * BK_NUM_VOICES
+ * BK_NUM_ACTIVE_VOICES
+ * BK_VOICE_STEALING
+ *
+ * All other attributes are read from the first voice
+ */
+extern BKInt BKVoicePoolGetAttr (BKVoicePool const * pool, BKEnum attr, BKInt * outValue);
+
+/**
+ * Set pointer on every voice
+ * E.g. BK_INSTRUMENT to share an instrument between voices
+ */
+extern BKInt BKVoicePoolSetPtr (BKVoicePool * pool, BKEnum attr, void * ptr, BKSize size);
+
+/**
+ * Get pointer from the first voice
+ */
+extern BKInt BKVoicePoolGetPtr (BKVoicePool const * pool, BKEnum attr, void * outPtr, BKSize size);
+
+#endif /* ! _BK_VOICE_POOL_H_ */
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2012-2016 Simon Schoenenberger
+ * http://blipkit.audio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "BKWorkers.h"
+
+#if BK_USE_THREADS
+
+#include <pthread.h>
+
+typedef struct BKWorkersThread BKWorkersThread;
+
+struct BKWorkersThreads
+{
+	pthread_t     * threads;
+	BKUInt          numThreads; // number of created threads
+	pthread_mutex_t mutex;
+	pthread_cond_t  startCond;
+	pthread_cond_t  doneCond;
+	BKUInt          generation; // incremented for each run
+	BKUInt          pending;    // number of threads still running
+	BKInt           quit;
+	BKWorkersFunc   func;
+	void          * info;
+};
+
+struct BKWorkersThread
+{
+	BKWorkersThreads * threads;
+	BKUInt             index;
+};
+
+static void * BKWorkersThreadMain (BKWorkersThread * thread)
+{
+	BKWorkersThreads * threads = thread -> threads;
+	BKUInt             index = thread -> index;
+	BKUInt             generation = 0;
+	BKWorkersFunc      func;
+	void             * info;
+
+	free (thread);
+
+	for (;;) {
+		pthread_mutex_lock (& threads -> mutex);
+
+		while (threads -> generation == generation && !threads -> quit)
+			pthread_cond_wait (& threads -> startCond, & threads -> mutex);
+
+		if (threads -> quit) {
+			pthread_mutex_unlock (& threads -> mutex);
+			break;
+		}
+
+		generation = threads -> generation;
+		func = threads -> func;
+		info = threads -> info;
+
+		pthread_mutex_unlock (& threads -> mutex);
+
+		func (info, index);
+
+		pthread_mutex_lock (& threads -> mutex);
+
+		if (-- threads -> pending == 0)
+			pthread_cond_signal (& threads -> doneCond);
+
+		pthread_mutex_unlock (& threads -> mutex);
+	}
+
+	return NULL;
+}
+
+static void BKWorkersThreadsDispose (BKWorkersThreads * threads)
+{
+	pthread_mutex_lock (& threads -> mutex);
+	threads -> quit = 1;
+	pthread_cond_broadcast (& threads -> startCond);
+	pthread_mutex_unlock (& threads -> mutex);
+
+	// index 0 is the calling thread
+	for (BKUInt i = 1; i < threads -> numThreads; i ++)
+		pthread_join (threads -> threads [i], NULL);
+
+	pthread_cond_destroy (& threads -> doneCond);
+	pthread_cond_destroy (& threads -> startCond);
+	pthread_mutex_destroy (& threads -> mutex);
+	free (threads -> threads);
+	free (threads);
+}
+
+BKInt BKWorkersInit (BKWorkers * workers, BKUInt numThreads)
+{
+	BKWorkersThreads * threads;
+	BKWorkersThread  * thread;
+
+	memset (workers, 0, sizeof (BKWorkers));
+
+	if (numThreads < 1 || numThreads > BK_MAX_THREADS) {
+		return BK_INVALID_VALUE;
+	}
+
+	workers -> numThreads = numThreads;
+
+	if (numThreads == 1) {
+		return 0;
+	}
+
+	threads = calloc (1, sizeof (BKWorkersThreads));
+
+	if (threads == NULL) {
+		return BK_ALLOCATION_ERROR;
+	}
+
+	threads -> threads = malloc (numThreads * sizeof (pthread_t));
+
+	if (threads -> threads == NULL) {
+		free (threads);
+		return BK_ALLOCATION_ERROR;
+	}
+
+	pthread_mutex_init (& threads -> mutex, NULL);
+	pthread_cond_init (& threads -> startCond, NULL);
+	pthread_cond_init (& threads -> doneCond, NULL);
+
+	for (threads -> numThreads = 1; threads -> numThreads < numThreads; threads -> numThreads ++) {
+		thread = malloc (sizeof (BKWorkersThread));
+
+		if (thread == NULL) {
+			break;
+		}
+
+		thread -> threads = threads;
+		thread -> index   = threads -> numThreads;
+
+		if (pthread_create (& threads -> threads [thread -> index], NULL, (void * (*) (void *)) BKWorkersThreadMain, thread) != 0) {
+			free (thread);
+			break;
+		}
+	}
+
+	if (threads -> numThreads < numThreads) {
+		BKWorkersThreadsDispose (threads);
+		workers -> numThreads = 0;
+
+		return BK_ALLOCATION_ERROR;
+	}
+
+	workers -> threads = threads;
+
+	return 0;
+}
+
+void BKWorkersDispose (BKWorkers * workers)
+{
+	if (workers -> threads) {
+		BKWorkersThreadsDispose (workers -> threads);
+	}
+
+	memset (workers, 0, sizeof (BKWorkers));
+}
+
+void BKWorkersRun (BKWorkers * workers, BKWorkersFunc func, void * info)
+{
+	BKWorkersThreads * threads = workers -> threads;
+
+	if (threads == NULL) {
+		func (info, 0);
+		return;
+	}
+
+	pthread_mutex_lock (& threads -> mutex);
+	threads -> func    = func;
+	threads -> info    = info;
+	threads -> pending = threads -> numThreads - 1;
+	threads -> generation ++;
+	pthread_cond_broadcast (& threads -> startCond);
+	pthread_mutex_unlock (& threads -> mutex);
+
+	func (info, 0);
+
+	pthread_mutex_lock (& threads -> mutex);
+
+	while (threads -> pending)
+		pthread_cond_wait (& threads -> doneCond, & threads -> mutex);
+
+	pthread_mutex_unlock (& threads -> mutex);
+}
+
+#else /* ! BK_USE_THREADS */
+
+BKInt BKWorkersInit (BKWorkers * workers, BKUInt numThreads)
+{
+	memset (workers, 0, sizeof (BKWorkers));
+
+	if (numThreads != 1) {
+		return BK_INVALID_VALUE;
+	}
+
+	workers -> numThreads = numThreads;
+
+	return 0;
+}
+
+void BKWorkersDispose (BKWorkers * workers)
+{
+	memset (workers, 0, sizeof (BKWorkers));
+}
+
+void BKWorkersRun (BKWorkers * workers, BKWorkersFunc func, void * info)
+{
+	func (info, 0);
+}
+
+#endif /* BK_USE_THREADS */
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2012-2016 Simon Schoenenberger
+ * http://blipkit.audio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * @file
+ * A group of threads running the same function in parallel
+ *
+ * The calling thread takes part in each run so a group of `numThreads`
+ * creates `numThreads - 1` additional threads.
+ */
+
+#ifndef _BK_WORKERS_H_
+#define _BK_WORKERS_H_
+
+#include "BKBase.h"
+
+typedef struct BKWorkers       BKWorkers;
+typedef struct BKWorkersThreads BKWorkersThreads;
+
+/**
+ * Called for each thread with its `index`
+ */
+typedef void (* BKWorkersFunc) (void * info, BKUInt index);
+
+struct BKWorkers
+{
+	BKUInt             numThreads;
+	BKWorkersThreads * threads; // NULL if only the calling thread is used
+};
+
+/**
+ * Initialize worker group with `numThreads` threads including the calling
+ * thread
+ *
+ * Errors:
+ * BK_INVALID_VALUE if `numThreads` is 0 or greater than `BK_MAX_THREADS` or if
+ * threads are not supported and `numThreads` is greater than 1
+ * BK_ALLOCATION_ERROR if threads could not be created
+ */
+extern BKInt BKWorkersInit (BKWorkers * workers, BKUInt numThreads);
+
+/**
+ * Stop threads and dispose worker group
+ */
+extern void BKWorkersDispose (BKWorkers * workers);
+
+/**
+ * Call `func` with indices from 0 to `numThreads - 1` in parallel
+ * The calling thread runs index 0
+ * Returns when all threads have finished
+ */
+extern void BKWorkersRun (BKWorkers * workers, BKWorkersFunc func, void * info);
+
+#endif /* ! _BK_WORKERS_H_ */
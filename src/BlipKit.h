@@ -42,12 +42,14 @@ extern "C" {
 #include "BKInstrument.h"
 #include "BKInterpolation.h"
 #include "BKObject.h"
+#include "BKRenderBatch.h"
 #include "BKSequence.h"
 #include "BKString.h"
 #include "BKTime.h"
 #include "BKTone.h"
 #include "BKTrack.h"
 #include "BKUnit.h"
+#include "BKVoicePool.h"
 #include "BKWaveFileReader.h"
 #include "BKWaveFileWriter.h"
 
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <time.h>
+#include "test.h"
+
+/**
+ * Measures reading frames from buffers filled with square wave pulses
+ * Run with `make bench` in this directory
+ */
+
+#define BENCH_SECONDS 60
+#define BENCH_CHUNK   512
+#define BENCH_PERIOD  100
+
+static double benchRead (BKBufferFuncs const * funcs, BKUInt sampleRate, BKUInt interlace)
+{
+	BKBuffer buffer;
+	BKFrame  frames [BENCH_CHUNK * 2];
+	BKFrame  pulse = 8000;
+	BKUInt   remaining = sampleRate * BENCH_SECONDS;
+	clock_t  readTime = 0, start;
+
+	BKBufferInit (& buffer);
+	buffer.funcs = funcs;
+
+	while (remaining) {
+		BKUInt size = BKMin (remaining, BENCH_CHUNK);
+
+		for (BKUInt t = 0; t < size; t += BENCH_PERIOD) {
+			BKBufferAddPulse (& buffer, t << BK_FINT20_SHIFT, pulse);
+			pulse = -pulse;
+		}
+
+		BKBufferEnd (& buffer, size << BK_FINT20_SHIFT);
+		BKBufferShift (& buffer, size << BK_FINT20_SHIFT);
+
+		start = clock ();
+		BKBufferRead (& buffer, frames, size, interlace);
+		readTime += clock () - start;
+
+		remaining -= size;
+	}
+
+	BKBufferDispose (& buffer);
+
+	return (double) readTime / CLOCKS_PER_SEC;
+}
+
+int main (int argc, char const * argv [])
+{
+	BKUInt const sampleRates [] = {44100, 96000};
+	BKBufferFuncs const * scalar = BKBufferGetFuncs (BK_BUFFER_FUNCS_SCALAR);
+	BKBufferFuncs const * best   = BKBufferGetBestFuncs ();
+
+	printf ("Reading %d seconds of frames, best functions type %d\n", BENCH_SECONDS, best -> type);
+
+	for (BKInt i = 0; i < 2; i ++) {
+		for (BKUInt interlace = 1; interlace <= 2; interlace ++) {
+			double scalarTime = benchRead (scalar, sampleRates [i], interlace);
+			double bestTime   = benchRead (best, sampleRates [i], interlace);
+
+			printf ("%6u Hz, interlace %u: scalar %.3fs, best %.3fs, speedup %.2fx\n",
+				sampleRates [i], interlace, scalarTime, bestTime, scalarTime / BKMax (bestTime, 1e-9));
+		}
+	}
+
+	return 0;
+}
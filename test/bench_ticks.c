@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <time.h>
+#include "test.h"
+
+/**
+ * Measures ticking many tracks with effects with and without `BK_BATCH_TICKS`
+ * Tracks are silent so the time is spent in ticking the tracks
+ * The best of a few alternating rounds is taken to reduce noise
+ * Run with `make bench` in this directory
+ */
+
+#define BENCH_SECONDS 10
+#define BENCH_ROUNDS  5
+#define BENCH_CHUNK   512
+
+static double benchTicks (BKUInt numTracks, BKInt batch)
+{
+	BKContext  ctx;
+	BKTrack  * tracks;
+	BKFrame    frames [BENCH_CHUNK * 2];
+	BKUInt     remaining = 44100 * BENCH_SECONDS;
+	BKInt      vibrato [3] = {12, 2 * BK_FINT20_UNIT, 0};
+	BKInt      tremolo [3] = {8, BK_MAX_VOLUME / 4, 0};
+	BKInt      portamento = 24;
+	clock_t    start;
+
+	BKContextInit (& ctx, 2, 44100);
+	BKSetAttr (& ctx, BK_BATCH_TICKS, batch);
+	tracks = calloc (numTracks, sizeof (BKTrack));
+
+	for (BKUInt i = 0; i < numTracks; i ++) {
+		BKTrackInit (& tracks [i], BK_SQUARE);
+		BKTrackAttach (& tracks [i], & ctx);
+		BKSetAttr (& tracks [i], BK_MASTER_VOLUME, 0);
+		// step effects on each tick
+		BKSetAttr (& tracks [i], BK_EFFECT_DIVIDER, 1);
+		BKSetAttr (& tracks [i], BK_VOLUME, BK_MAX_VOLUME);
+		BKSetAttr (& tracks [i], BK_NOTE, (BK_C_3 + i % 36) * BK_FINT20_UNIT);
+		BKSetPtr (& tracks [i], BK_EFFECT_VIBRATO, vibrato, sizeof (vibrato));
+		BKSetPtr (& tracks [i], BK_EFFECT_TREMOLO, tremolo, sizeof (tremolo));
+		BKSetPtr (& tracks [i], BK_EFFECT_PORTAMENTO, & portamento, sizeof (portamento));
+	}
+
+	start = clock ();
+
+	while (remaining) {
+		BKUInt size = BKMin (remaining, BENCH_CHUNK);
+
+		BKContextGenerate (& ctx, frames, size);
+		remaining -= size;
+	}
+
+	start = clock () - start;
+
+	for (BKUInt i = 0; i < numTracks; i ++)
+		BKDispose (& tracks [i]);
+
+	free (tracks);
+	BKDispose (& ctx);
+
+	return (double) start / CLOCKS_PER_SEC;
+}
+
+int main (int argc, char const * argv [])
+{
+	BKUInt const numTracks [] = {16, 256, 1024};
+
+	printf ("Generating %d seconds of frames at 44100 Hz, best of %d rounds\n", BENCH_SECONDS, BENCH_ROUNDS);
+
+	for (BKInt i = 0; i < 3; i ++) {
+		double times [2] = {1e9, 1e9};
+
+		for (BKInt r = 0; r < BENCH_ROUNDS; r ++) {
+			for (BKInt batch = 0; batch < 2; batch ++)
+				times [batch] = BKMin (times [batch], benchTicks (numTracks [i], batch));
+		}
+
+		printf ("%5u tracks: %.3fs separate, %.3fs batch\n", numTracks [i], times [0], times [1]);
+	}
+
+	return 0;
+}
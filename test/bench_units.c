@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <time.h>
+#include "test.h"
+
+/**
+ * Measures running many units attached to a single context
+ * Units are allocated separately like tracks created with `BKTrackAlloc` and
+ * have long periods so the time is spent in walking the units
+ * Run with `make bench` in this directory
+ */
+
+#define BENCH_SECONDS 60
+#define BENCH_CHUNK   64
+#define BENCH_SPREAD  4096
+
+static double benchUnits (BKUInt numUnits, BKUInt sampleRate)
+{
+	BKContext ctx;
+	BKUnit ** units;
+	void   ** spread;
+	BKFrame   frames [BENCH_CHUNK * 2];
+	BKUInt    remaining = sampleRate * BENCH_SECONDS;
+	BKEnum    waveforms [] = {BK_SQUARE, BK_TRIANGLE, BK_NOISE, BK_SAWTOOTH};
+	clock_t   start;
+
+	BKContextInit (& ctx, 2, sampleRate);
+	units  = calloc (numUnits, sizeof (BKUnit *));
+	spread = calloc (numUnits, sizeof (void *));
+
+	for (BKUInt i = 0; i < numUnits; i ++) {
+		units [i]  = malloc (sizeof (BKUnit));
+		// keep units apart like other allocations would do
+		spread [i] = malloc (BENCH_SPREAD);
+
+		BKUnitInit (units [i], waveforms [i % 4]);
+		BKUnitAttach (units [i], & ctx);
+		BKSetAttr (units [i], BK_VOLUME, BK_MAX_VOLUME / numUnits);
+		// spread periods between 2000 and 2255 frames
+		BKSetAttr (units [i], BK_PERIOD, ((2000 + i % 256) << BK_FINT20_SHIFT) / 16);
+	}
+
+	start = clock ();
+
+	while (remaining) {
+		BKUInt size = BKMin (remaining, BENCH_CHUNK);
+
+		BKContextGenerate (& ctx, frames, size);
+		remaining -= size;
+	}
+
+	start = clock () - start;
+
+	for (BKUInt i = 0; i < numUnits; i ++) {
+		BKDispose (units [i]);
+		free (units [i]);
+		free (spread [i]);
+	}
+
+	free (units);
+	free (spread);
+	BKDispose (& ctx);
+
+	return (double) start / CLOCKS_PER_SEC;
+}
+
+int main (int argc, char const * argv [])
+{
+	BKUInt const numUnits [] = {16, 256, 1024};
+
+	printf ("Generating %d seconds of frames at 44100 Hz\n", BENCH_SECONDS);
+
+	for (BKInt i = 0; i < 3; i ++) {
+		double time = benchUnits (numUnits [i], 44100);
+
+		printf ("%5u units: %.3fs\n", numUnits [i], time);
+	}
+
+	return 0;
+}
@@ -0,0 +1,270 @@
+#include "test.h"
+
+static BKUInt seed = 0x1234;
+
+static BKInt randomValue (void)
+{
+	seed = seed * 1103515245 + 12345;
+
+	return (BKInt) (seed >> 8);
+}
+
+/**
+ * Get random time before frame `numFrames`
+ */
+static BKFUInt20 randomTime (BKUInt numFrames)
+{
+	BKFUInt20 frame = (BKFUInt20) randomValue () % numFrames;
+
+	return (frame << BK_FINT20_SHIFT) | ((BKFUInt20) randomValue () & BK_FINT20_FRAC);
+}
+
+int main (int argc, char const * argv [])
+{
+	BKBuffer buffer, reference;
+	BKFrame const pulses [] = {0, 1, -1, 1234, -4321, BK_FRAME_MAX, INT16_MIN};
+	BKInt numPulses = sizeof (pulses) / sizeof (pulses [0]);
+	BKBufferFuncs const * scalar;
+	BKBufferFuncs const * funcs;
+	BKBufferPulse generated [4];
+	BKBufferPulse const * kernels [6];
+	BKInt numKernels = 0;
+
+	scalar = BKBufferGetFuncs (BK_BUFFER_FUNCS_SCALAR);
+
+	// check generated kernels
+	assert (BKBufferPulseInit (& generated [0], 8, 16, 0.8) == 0);
+	assert (BKBufferPulseInit (& generated [1], 16, 64, 0.9) == 0);
+	assert (BKBufferPulseInit (& generated [2], 32, 32, 1.0) == 0);
+	assert (BKBufferPulseInit (& generated [3], 64, 256, 0.95) == 0);
+
+	for (BKInt k = 0; k < 4; k ++) {
+		BKBufferPulse const * kernel = & generated [k];
+
+		assert (BKBufferPulseIsValid (kernel));
+
+		for (BKInt frac = 0; frac < (1 << kernel -> phaseShift); frac ++) {
+			BKInt sum = 0;
+
+			for (BKInt i = 0; i < kernel -> width; i ++)
+				sum += kernel -> frames [frac * kernel -> width + i];
+
+			assert (sum == BK_FRAME_MAX);
+		}
+	}
+
+	// equals `sinc_phases.c`
+	assert (memcmp (generated [2].frames, BKBufferPulseKernels [BK_PULSE_KERNEL_SINC] -> frames, BK_STEP_UNIT * BK_STEP_WIDTH * sizeof (BKFrame)) == 0);
+
+	{
+		BKBufferPulse invalid;
+
+		assert (BKBufferPulseInit (& invalid, 12, 32, 1.0) == BK_INVALID_VALUE);
+		assert (BKBufferPulseInit (& invalid, 128, 32, 1.0) == BK_INVALID_VALUE);
+		assert (BKBufferPulseInit (& invalid, 32, 48, 1.0) == BK_INVALID_VALUE);
+		assert (BKBufferPulseInit (& invalid, 32, 512, 1.0) == BK_INVALID_VALUE);
+		assert (BKBufferPulseInit (& invalid, 32, 32, 0.0) == BK_INVALID_VALUE);
+		assert (BKBufferPulseInit (& invalid, 32, 32, 1.5) == BK_INVALID_VALUE);
+		assert (!BKBufferPulseIsValid (& invalid));
+	}
+
+	kernels [numKernels ++] = BKBufferPulseKernels [BK_PULSE_KERNEL_SINC];
+	kernels [numKernels ++] = BKBufferPulseKernels [BK_PULSE_KERNEL_HARM];
+
+	for (BKInt k = 0; k < 4; k ++)
+		kernels [numKernels ++] = & generated [k];
+
+	assert (scalar != NULL);
+	assert (BKBufferGetBestFuncs () != NULL);
+
+	for (BKInt type = 0; type < BK_BUFFER_FUNCS_COUNT; type ++) {
+		funcs = BKBufferGetFuncs (type);
+
+		// not supported by host CPU
+		if (funcs == NULL)
+			continue;
+
+		assert (funcs -> type == type);
+
+		// check single pulses of all kernels and phases
+		for (BKInt k = 0; k < numKernels; k ++) {
+			BKBufferPulse const * kernel = kernels [k];
+
+			for (BKInt frac = 0; frac < (1 << kernel -> phaseShift); frac ++) {
+				BKFrame const * phase = & kernel -> frames [frac * kernel -> width];
+
+				for (BKInt p = 0; p < numPulses; p ++) {
+					BKInt frames [BK_MAX_STEP_WIDTH], expected [BK_MAX_STEP_WIDTH];
+
+					for (BKInt i = 0; i < BK_MAX_STEP_WIDTH; i ++)
+						frames [i] = expected [i] = randomValue ();
+
+					scalar -> addPulse (expected, phase, kernel -> width, pulses [p]);
+					funcs -> addPulse (frames, phase, kernel -> width, pulses [p]);
+
+					assert (memcmp (frames, expected, sizeof (frames)) == 0);
+				}
+			}
+		}
+
+		// check float conversion
+		for (BKUInt count = 0; count < 40; count ++) {
+			BKInt values [40];
+			float floats [40], expectedFloats [40];
+
+			for (BKInt i = 0; i < count; i ++)
+				values [i] = randomValue () * 7;
+
+			scalar -> convertFloat (expectedFloats, values, count);
+			funcs -> convertFloat (floats, values, count);
+
+			assert (memcmp (floats, expectedFloats, count * sizeof (float)) == 0);
+		}
+
+		// check clamping to 16 bit including values out of range
+		for (BKUInt count = 0; count < 40; count ++) {
+			BKInt   values [40];
+			BKFrame frames [40], expectedFrames [40];
+
+			for (BKInt i = 0; i < count; i ++)
+				values [i] = (randomValue () << 8) ^ randomValue ();
+
+			if (count >= 2) {
+				values [0] = BK_INT_MAX;
+				values [1] = -BK_INT_MAX - 1;
+			}
+
+			scalar -> clampFrames (expectedFrames, values, count);
+			funcs -> clampFrames (frames, values, count);
+
+			assert (memcmp (frames, expectedFrames, count * sizeof (BKFrame)) == 0);
+		}
+
+		// check buffers filled with pulses at random offsets
+		BKBufferInit (& buffer);
+		BKBufferInit (& reference);
+
+		buffer.funcs = funcs;
+
+		for (BKInt i = 0; i < 10000; i ++) {
+			BKFUInt20 time  = randomTime (BK_DEFAULT_BUFFER_SIZE);
+			BKFrame   pulse = randomValue ();
+
+			BKBufferAddPulse (& buffer, time, pulse);
+			BKBufferAddPulse (& reference, time, pulse);
+		}
+
+		assert (memcmp (buffer.frames, reference.frames, (buffer.size + BK_MAX_STEP_WIDTH) * sizeof (BKInt)) == 0);
+
+		// check batched pulses
+		for (BKInt i = 0; i < 100; i ++) {
+			BKFUInt20 times [64];
+			BKFrame   deltas [64];
+			BKUInt    count = randomValue () % 64;
+
+			for (BKInt j = 0; j < count; j ++) {
+				times [j]  = randomTime (BK_DEFAULT_BUFFER_SIZE);
+				deltas [j] = randomValue ();
+
+				BKBufferAddPulse (& reference, times [j], deltas [j]);
+			}
+
+			BKBufferAddPulses (& buffer, times, deltas, count);
+		}
+
+		assert (memcmp (buffer.frames, reference.frames, (buffer.size + BK_MAX_STEP_WIDTH) * sizeof (BKInt)) == 0);
+
+		// check batched pulses with multiple pulses per frame
+		for (BKInt i = 0; i < 100; i ++) {
+			BKFUInt20 times [64];
+			BKFrame   deltas [64];
+			BKUInt    count = randomValue () % 64;
+			// leave room for 64 pulses less than a third frame apart
+			BKFUInt20 time = randomTime (BK_DEFAULT_BUFFER_SIZE - 32);
+
+			for (BKInt j = 0; j < count; j ++) {
+				times [j]  = time;
+				deltas [j] = randomValue ();
+				time += randomValue () % (BK_FINT20_UNIT / 3);
+
+				BKBufferAddPulse (& reference, times [j], deltas [j]);
+			}
+
+			BKBufferAddPulses (& buffer, times, deltas, count);
+		}
+
+		assert (memcmp (buffer.frames, reference.frames, (buffer.size + BK_MAX_STEP_WIDTH) * sizeof (BKInt)) == 0);
+
+		BKBufferDispose (& buffer);
+		BKBufferDispose (& reference);
+	}
+
+	// check reading across the ring buffer wrap point in different chunk sizes
+	BKBufferInit (& buffer);
+	BKBufferInit (& reference);
+
+	for (BKInt round = 0; round < 50; round ++) {
+		BKFrame frames [1000], expected [1000];
+		BKUInt  size;
+
+		for (BKInt i = 0; i < 200; i ++) {
+			BKFUInt20 time  = (randomValue () & ((1 << 30) - 1)) % (1000 << BK_FINT20_SHIFT);
+			BKFrame   pulse = randomValue ();
+
+			BKBufferAddPulse (& buffer, time, pulse);
+			BKBufferAddPulse (& reference, time, pulse);
+		}
+
+		BKBufferEnd (& buffer, 1000 << BK_FINT20_SHIFT);
+		BKBufferEnd (& reference, 1000 << BK_FINT20_SHIFT);
+		BKBufferShift (& buffer, 1000 << BK_FINT20_SHIFT);
+		BKBufferShift (& reference, 1000 << BK_FINT20_SHIFT);
+
+		assert (BKBufferRead (& reference, expected, 1000, 1) == 1000);
+
+		for (BKUInt offset = 0; offset < 1000; offset += size) {
+			size = (BKUInt) randomValue () % 97 + 1;
+			size = BKMin (size, 1000 - offset);
+			assert (BKBufferRead (& buffer, & frames [offset], size, 1) == size);
+		}
+
+		assert (memcmp (frames, expected, sizeof (frames)) == 0);
+	}
+
+	// check resizing keeps buffered frames
+	for (BKInt round = 0; round < 20; round ++) {
+		BKFrame frames [1000], expected [1000];
+
+		for (BKInt i = 0; i < 200; i ++) {
+			BKFUInt20 time  = (randomValue () & ((1 << 30) - 1)) % (1000 << BK_FINT20_SHIFT);
+			BKFrame   pulse = randomValue ();
+
+			BKBufferAddPulse (& buffer, time, pulse);
+			BKBufferAddPulse (& reference, time, pulse);
+		}
+
+		BKBufferEnd (& buffer, 1000 << BK_FINT20_SHIFT);
+		BKBufferEnd (& reference, 1000 << BK_FINT20_SHIFT);
+		BKBufferShift (& buffer, 1000 << BK_FINT20_SHIFT);
+		BKBufferShift (& reference, 1000 << BK_FINT20_SHIFT);
+
+		assert (BKBufferRead (& buffer, frames, 500, 1) == 500);
+		assert (BKBufferRead (& reference, expected, 500, 1) == 500);
+		assert (BKBufferSetSize (& buffer, (round & 1) ? 100 : 20000) == 0);
+		assert (BKBufferRead (& buffer, & frames [500], 500, 1) == 500);
+		assert (BKBufferRead (& reference, & expected [500], 500, 1) == 500);
+
+		assert (memcmp (frames, expected, sizeof (frames)) == 0);
+	}
+
+	assert (BKBufferSetSize (& buffer, 0) == BK_INVALID_VALUE);
+	assert (BKBufferSetSize (& buffer, BK_MAX_BUFFER_SIZE + 1) == BK_INVALID_VALUE);
+
+	BKBufferDispose (& buffer);
+	BKBufferDispose (& reference);
+
+	for (BKInt k = 0; k < 4; k ++)
+		BKBufferPulseDispose (& generated [k]);
+
+	return 0;
+}
@@ -1,4 +1,51 @@
 #include "test.h"
+#include "BKContext_internal.h"
+
+typedef struct {
+	BKUInt hash;
+	BKUInt numFrames;
+} Checksum;
+
+static BKInt writeChecksum (BKFrame inFrames [], BKUInt size, Checksum * sum)
+{
+	for (BKUInt i = 0; i < size * 2; i ++)
+		sum -> hash = sum -> hash * 31 + (BKUInt) inFrames [i];
+
+	sum -> numFrames += size;
+
+	return 0;
+}
+
+static void countProgress (BKRenderJob const * job, BKInt * count)
+{
+	__atomic_add_fetch (count, 1, __ATOMIC_RELAXED);
+}
+
+typedef struct {
+	BKInt index;
+	BKInt * log;
+	BKInt * logSize;
+} ClockInfo;
+
+static BKEnum logClockTick (BKCallbackInfo * info, ClockInfo * clockInfo)
+{
+	clockInfo -> log [(* clockInfo -> logSize) ++] = clockInfo -> index;
+
+	return 0;
+}
+
+typedef struct {
+	BKUnit * unit;
+	BKContext * ctx;
+	BKInt result;
+} AttachInfo;
+
+static BKEnum attachUnitFromSampleCallback (BKCallbackInfo * info, AttachInfo * attachInfo)
+{
+	attachInfo -> result = BKUnitAttach (attachInfo -> unit, attachInfo -> ctx);
+
+	return 0;
+}
 
 int main (int argc, char const * argv [])
 {
@@ -23,5 +70,596 @@ int main (int argc, char const * argv [])
 
 	BKDispose (ctx);
 
+	// check float output against 16 bit output
+	// 16 bit frames are truncated and float frames may be rounded
+
+	BKContext * floatCtx;
+	BKTrack * track, * floatTrack;
+	BKFrame frames [2 * 3000];
+	float floatFrames [2 * 3000];
+	float planarFrames [2][3000];
+	float * planar [2] = {planarFrames [0], planarFrames [1]};
+
+	BKContextAlloc (& ctx, 2, 44100);
+	BKContextAlloc (& floatCtx, 2, 44100);
+	BKTrackAlloc (& track, BK_SQUARE);
+	BKTrackAlloc (& floatTrack, BK_SQUARE);
+
+	BKSetAttr (track, BK_MASTER_VOLUME, BK_MAX_VOLUME / 4);
+	BKSetAttr (track, BK_VOLUME, BK_MAX_VOLUME);
+	BKSetAttr (track, BK_NOTE, BK_C_4);
+	BKSetAttr (floatTrack, BK_MASTER_VOLUME, BK_MAX_VOLUME / 4);
+	BKSetAttr (floatTrack, BK_VOLUME, BK_MAX_VOLUME);
+	BKSetAttr (floatTrack, BK_NOTE, BK_C_4);
+
+	BKTrackAttach (track, ctx);
+	BKTrackAttach (floatTrack, floatCtx);
+
+	res = BKContextGenerate (ctx, frames, 3000);
+	assert (res == 3000);
+
+	res = BKContextGenerateFloat (floatCtx, floatFrames, 3000);
+	assert (res == 3000);
+
+	for (BKInt i = 0; i < 2 * 3000; i ++) {
+		float frame = floatFrames [i] * (BK_FRAME_MAX + 1);
+		assert (frame > frames [i] - 0.01 && frame < frames [i] + 1.01);
+	}
+
+	res = BKContextGenerate (ctx, frames, 3000);
+	assert (res == 3000);
+
+	res = BKContextGenerateFloatPlanar (floatCtx, planar, 3000);
+	assert (res == 3000);
+
+	for (BKInt i = 0; i < 3000; i ++) {
+		for (BKInt c = 0; c < 2; c ++) {
+			float frame = planarFrames [c][i] * (BK_FRAME_MAX + 1);
+			assert (frame > frames [i * 2 + c] - 0.01 && frame < frames [i * 2 + c] + 1.01);
+		}
+	}
+
+	// check planar output against interlaced output
+
+	BKFrame planarIntFrames [2][3000];
+	BKFrame * planarInt [2] = {planarIntFrames [0], planarIntFrames [1]};
+
+	res = BKContextGenerate (ctx, frames, 3000);
+	assert (res == 3000);
+
+	res = BKContextGeneratePlanar (floatCtx, planarInt, 3000);
+	assert (res == 3000);
+
+	for (BKInt i = 0; i < 3000; i ++) {
+		assert (planarIntFrames [0][i] == frames [i * 2 + 0]);
+		assert (planarIntFrames [1][i] == frames [i * 2 + 1]);
+	}
+
+	BKDispose (track);
+	BKDispose (floatTrack);
+	BKDispose (ctx);
+	BKDispose (floatCtx);
+
+	// check larger buffer size gives the same frames
+
+	static BKFrame longFrames [2 * 100000], expectedLongFrames [2 * 100000];
+	BKInt bufferSize;
+	BKContext * defaultCtx;
+	BKTrack * defaultTrack;
+
+	BKContextAlloc (& ctx, 2, 44100);
+	BKContextAlloc (& defaultCtx, 2, 44100);
+	BKTrackAlloc (& track, BK_TRIANGLE);
+	BKTrackAlloc (& defaultTrack, BK_TRIANGLE);
+
+	assert (BKSetAttr (ctx, BK_BUFFER_SIZE, 10) == BK_INVALID_VALUE);
+	assert (BKSetAttr (ctx, BK_BUFFER_SIZE, 1 << 16) == 0);
+	assert (BKGetAttr (ctx, BK_BUFFER_SIZE, & bufferSize) == 0);
+	assert (bufferSize == 1 << 16);
+
+	BKSetAttr (track, BK_VOLUME, BK_MAX_VOLUME);
+	BKSetAttr (track, BK_NOTE, BK_A_2);
+	BKSetAttr (defaultTrack, BK_VOLUME, BK_MAX_VOLUME);
+	BKSetAttr (defaultTrack, BK_NOTE, BK_A_2);
+
+	BKTrackAttach (track, ctx);
+	BKTrackAttach (defaultTrack, defaultCtx);
+
+	res = BKContextGenerate (ctx, longFrames, 100000);
+	assert (res == 100000);
+
+	res = BKContextGenerate (defaultCtx, expectedLongFrames, 100000);
+	assert (res == 100000);
+
+	assert (memcmp (longFrames, expectedLongFrames, sizeof (longFrames)) == 0);
+
+	BKDispose (track);
+	BKDispose (defaultTrack);
+	BKDispose (ctx);
+	BKDispose (defaultCtx);
+
+	// check rendering with threads gives the same frames
+
+	BKInt const numThreads [] = {1, 2, 3, 8};
+	BKInt const waveforms [] = {BK_SQUARE, BK_TRIANGLE, BK_NOISE, BK_SAWTOOTH, BK_SINE};
+	BKTrack * tracks [4][24];
+	BKContext * contexts [4];
+	BKInt value;
+
+	for (BKInt c = 0; c < 4; c ++) {
+		BKContextAlloc (& contexts [c], 2, 44100);
+
+		if (numThreads [c] > 1 && BKSetAttr (contexts [c], BK_NUM_THREADS, numThreads [c]) == BK_INVALID_VALUE) {
+			// built without threads
+			assert (BKGetAttr (contexts [c], BK_NUM_THREADS, & value) == 0 && value == 1);
+		}
+
+		for (BKInt i = 0; i < 24; i ++) {
+			BKTrackAlloc (& tracks [c][i], waveforms [i % 5]);
+			BKSetAttr (tracks [c][i], BK_MASTER_VOLUME, BK_MAX_VOLUME / 16);
+			BKSetAttr (tracks [c][i], BK_VOLUME, BK_MAX_VOLUME);
+			BKSetAttr (tracks [c][i], BK_PANNING, (i * 2731) % BK_MAX_VOLUME - BK_MAX_VOLUME / 2);
+			BKSetAttr (tracks [c][i], BK_NOTE, (BK_C_2 + i * 3) * BK_FINT20_UNIT);
+			BKTrackAttach (tracks [c][i], contexts [c]);
+
+			if (i % 3 == 0) {
+				BKInt vibrato [2] = {8 + i, 2 * BK_FINT20_UNIT};
+				BKSetPtr (tracks [c][i], BK_EFFECT_VIBRATO, vibrato, sizeof (vibrato));
+			}
+		}
+	}
+
+	assert (BKSetAttr (contexts [0], BK_NUM_THREADS, 0) == BK_INVALID_VALUE);
+	assert (BKSetAttr (contexts [0], BK_NUM_THREADS, BK_MAX_THREADS + 1) == BK_INVALID_VALUE);
+
+	for (BKInt round = 0; round < 4; round ++) {
+		for (BKInt c = 0; c < 4; c ++) {
+			// change notes between runs
+			for (BKInt i = round; i < 24; i += 4)
+				BKSetAttr (tracks [c][i], BK_NOTE, (BK_C_3 + i + round) * BK_FINT20_UNIT);
+
+			res = BKContextGenerate (contexts [c], c ? longFrames : expectedLongFrames, 25000);
+			assert (res == 25000);
+
+			if (c)
+				assert (memcmp (longFrames, expectedLongFrames, 2 * 25000 * sizeof (BKFrame)) == 0);
+		}
+	}
+
+	for (BKInt c = 0; c < 4; c ++) {
+		for (BKInt i = 0; i < 24; i ++)
+			BKDispose (tracks [c][i]);
+
+		BKDispose (contexts [c]);
+	}
+
+	// check units cannot be attached from sample callbacks run by threads
+
+	BKData     sampleData;
+	BKFrame    sampleFrames [2 * 4] = {0};
+	BKUnit     sampleUnit, attachedUnit;
+	AttachInfo attachInfo;
+	BKCallback sampleCallback;
+	BKInt      expectedResult = BK_INVALID_STATE;
+
+	BKContextAlloc (& ctx, 2, 44100);
+
+	if (BKSetAttr (ctx, BK_NUM_THREADS, 2) == BK_INVALID_VALUE) {
+		// built without threads
+		expectedResult = 0;
+	}
+
+	BKDataInit (& sampleData);
+	BKDataSetFrames (& sampleData, sampleFrames, 4, 2, 1);
+	BKUnitInit (& sampleUnit, BK_SQUARE);
+	BKUnitInit (& attachedUnit, BK_SQUARE);
+
+	attachInfo.unit   = & attachedUnit;
+	attachInfo.ctx    = ctx;
+	attachInfo.result = -1;
+
+	sampleCallback.func     = (BKCallbackFunc) attachUnitFromSampleCallback;
+	sampleCallback.userInfo = & attachInfo;
+
+	BKUnitAttach (& sampleUnit, ctx);
+	BKSetAttr (& sampleUnit, BK_VOLUME, BK_MAX_VOLUME);
+	BKSetPtr (& sampleUnit, BK_SAMPLE, & sampleData, 0);
+	BKSetAttr (& sampleUnit, BK_PERIOD, BK_FINT20_UNIT);
+	BKSetAttr (& sampleUnit, BK_SAMPLE_PERIOD, BK_FINT20_UNIT);
+	BKSetPtr (& sampleUnit, BK_SAMPLE_CALLBACK, & sampleCallback, sizeof (sampleCallback));
+
+	BKContextGenerate (ctx, frames, 100);
+
+	assert (attachInfo.result == expectedResult);
+	assert ((attachedUnit.ctx == ctx) == (expectedResult == 0));
+	assert ((ctx -> flags & BK_CONTEXT_FLAG_WORKERS) == 0);
+
+	BKDispose (& sampleUnit);
+	BKDispose (& attachedUnit);
+	BKDispose (& sampleData);
+	BKDispose (ctx);
+
+	// check batch rendering gives the same frames as rendering each context
+
+	BKRenderBatch batch;
+	BKRenderJob jobs [9];
+	Checksum sums [9], expectedSums [9];
+	BKInt numProgress = 0;
+
+	if (BKRenderBatchInit (& batch, 3) == BK_INVALID_VALUE) {
+		// built without threads
+		assert (BKRenderBatchInit (& batch, 1) == 0);
+	}
+
+	for (BKInt round = 0; round < 2; round ++) {
+		for (BKInt j = 0; j < 9; j ++) {
+			BKContextAlloc (& contexts [0], 2, 44100);
+			BKTrackAlloc (& track, waveforms [j % 5]);
+			BKSetAttr (track, BK_MASTER_VOLUME, BK_MAX_VOLUME / 4);
+			BKSetAttr (track, BK_VOLUME, BK_MAX_VOLUME);
+			BKSetAttr (track, BK_NOTE, (BK_C_3 + j) * BK_FINT20_UNIT);
+			BKTrackAttach (track, contexts [0]);
+
+			memset (& sums [j], 0, sizeof (Checksum));
+
+			if (round == 0) {
+				res = BKContextGenerateToTime (contexts [0], BKTimeFromSeconds (contexts [0], 0.1 * (j + 1)), (void *) writeChecksum, & sums [j]);
+				assert (res == sums [j].numFrames);
+				expectedSums [j] = sums [j];
+
+				BKDispose (track);
+				BKDispose (contexts [0]);
+			}
+			else {
+				jobs [j].ctx     = contexts [0];
+				jobs [j].endTime = BKTimeFromSeconds (contexts [0], 0.1 * (j + 1));
+				jobs [j].write   = (BKRenderWriteFunc) writeChecksum;
+				jobs [j].info    = & sums [j];
+				tracks [0][j]    = track;
+			}
+		}
+	}
+
+	assert (BKRenderBatchRun (& batch, jobs, 9, (BKRenderProgressFunc) countProgress, & numProgress) == 0);
+	assert (numProgress > 0);
+	assert (batch.numFrames > 0);
+
+	for (BKInt j = 0; j < 9; j ++) {
+		assert (BKRenderJobGetState (& jobs [j]) == BK_RENDER_JOB_DONE);
+		assert (jobs [j].result == expectedSums [j].numFrames);
+		assert (BKRenderJobGetNumFrames (& jobs [j]) == expectedSums [j].numFrames);
+		assert (BKRenderJobGetThroughput (& jobs [j]) > 0.0);
+		assert (sums [j].hash == expectedSums [j].hash);
+
+		BKDispose (tracks [0][j]);
+		BKDispose (jobs [j].ctx);
+	}
+
+	BKRenderBatchDispose (& batch);
+
+	// check queued commands
+
+	BKInt note;
+
+	BKContextAlloc (& ctx, 2, 44100);
+	BKTrackAlloc (& track, BK_SQUARE);
+	BKSetAttr (track, BK_VOLUME, BK_MAX_VOLUME);
+	BKTrackAttach (track, ctx);
+
+	assert (BKSetAttr (ctx, BK_COMMAND_QUEUE_SIZE, 3) == 0);
+	assert (BKGetAttr (ctx, BK_COMMAND_QUEUE_SIZE, & value) == 0 && value == 4);
+
+	assert (BKContextPushCommand (ctx, track, BK_NOTE, BK_C_4 * BK_FINT20_UNIT, BK_TIME_ZERO) == 0);
+	assert (BKContextPushCommand (ctx, track, BK_NOTE, BK_D_4 * BK_FINT20_UNIT, BKTimeFromSeconds (ctx, 1.0)) == 0);
+	assert (BKContextPushCommand (ctx, track, BK_NOTE, BK_E_4 * BK_FINT20_UNIT, BK_TIME_ZERO) == 0);
+	assert (BKContextPushCommand (ctx, track, BK_NOTE, BK_F_4 * BK_FINT20_UNIT, BK_TIME_ZERO) == 0);
+	assert (BKContextPushCommand (ctx, track, BK_NOTE, BK_G_4 * BK_FINT20_UNIT, BK_TIME_ZERO) == BK_INVALID_STATE);
+
+	// taking commands does not reallocate events
+	void * eventItems = ctx -> events.items;
+
+	// commands at the same time are applied in order
+	BKContextGenerate (ctx, frames, 1000);
+	assert (ctx -> events.items == eventItems);
+	assert (BKGetAttr (track, BK_NOTE, & note) == 0 && note == BK_F_4 * BK_FINT20_UNIT);
+	assert (BKContextPushCommand (ctx, track, BK_NOTE, BK_G_4 * BK_FINT20_UNIT, BK_TIME_ZERO) == 0);
+
+	for (BKInt i = 0; i < 43; i ++)
+		BKContextGenerate (ctx, frames, 1000);
+
+	assert (BKGetAttr (track, BK_NOTE, & note) == 0 && note == BK_G_4 * BK_FINT20_UNIT);
+
+	BKContextGenerate (ctx, frames, 1000);
+	assert (BKGetAttr (track, BK_NOTE, & note) == 0 && note == BK_D_4 * BK_FINT20_UNIT);
+
+	BKDispose (track);
+	BKDispose (ctx);
+
+	// check scheduled commands are applied between clock ticks
+
+	BKFrame scheduledFrames [2 * 3000];
+	BKContext * referenceCtx;
+	BKTrack * referenceTrack;
+
+	BKContextAlloc (& ctx, 2, 44100);
+	BKContextAlloc (& referenceCtx, 2, 44100);
+	BKTrackAlloc (& track, BK_SQUARE);
+	BKTrackAlloc (& referenceTrack, BK_SQUARE);
+
+	BKSetAttr (track, BK_MASTER_VOLUME, BK_MAX_VOLUME / 4);
+	BKSetAttr (track, BK_VOLUME, BK_MAX_VOLUME);
+	BKSetAttr (track, BK_NOTE, BK_C_5 * BK_FINT20_UNIT);
+	BKSetAttr (referenceTrack, BK_MASTER_VOLUME, BK_MAX_VOLUME / 4);
+	BKSetAttr (referenceTrack, BK_VOLUME, BK_MAX_VOLUME);
+	BKSetAttr (referenceTrack, BK_NOTE, BK_C_5 * BK_FINT20_UNIT);
+	BKTrackAttach (track, ctx);
+	BKTrackAttach (referenceTrack, referenceCtx);
+
+	assert (BKContextScheduleAttr (ctx, track, BK_MASTER_VOLUME, 0, BKTimeMake (2200, 0)) == 0);
+	assert (BKContextScheduleAttr (ctx, track, BK_NOTE, BK_C_2 * BK_FINT20_UNIT, BKTimeMake (1234, BK_FINT20_UNIT / 2)) == 0);
+	assert (BKContextScheduleAttr (ctx, referenceTrack, BK_NOTE, BK_C_2 * BK_FINT20_UNIT, BKTimeMake (1000, 0)) == 0);
+	BKContextUnscheduleObject (ctx, referenceTrack);
+	assert (ctx -> events.len == 2);
+
+	BKContextGenerate (ctx, scheduledFrames, 3000);
+	BKContextGenerate (referenceCtx, frames, 3000);
+
+	assert (ctx -> events.len == 0);
+	assert (memcmp (scheduledFrames, frames, 2 * 1234 * sizeof (BKFrame)) == 0);
+	assert (memcmp (& scheduledFrames [2 * 1234], & frames [2 * 1234], 2 * 200 * sizeof (BKFrame)) != 0);
+
+	BKDispose (referenceTrack);
+	BKDispose (referenceCtx);
+
+	BKDispose (track);
+	BKDispose (ctx);
+
+	// check scheduled commands are applied without clocks
+
+	BKUnit unit;
+	BKInt  volume;
+
+	BKContextAlloc (& ctx, 2, 44100);
+	BKUnitInit (& unit, BK_SQUARE);
+	BKSetAttr (& unit, BK_VOLUME, BK_MAX_VOLUME);
+	BKSetAttr (& unit, BK_PERIOD, 100 * BK_FINT20_UNIT);
+	BKUnitAttach (& unit, ctx);
+
+	assert (ctx -> firstClock == NULL);
+	assert (BKContextScheduleAttr (ctx, & unit, BK_VOLUME, 0, BKTimeMake (2200, 0)) == 0);
+
+	BKContextGenerate (ctx, scheduledFrames, 2000);
+
+	assert (BKTimeGetTime (ctx -> currentTime) == 2000);
+	assert (BKGetAttr (& unit, BK_VOLUME_0, & volume) == 0 && volume == BK_MAX_VOLUME);
+
+	BKContextGenerate (ctx, scheduledFrames, 1000);
+
+	assert (ctx -> events.len == 0);
+	assert (BKGetAttr (& unit, BK_VOLUME_0, & volume) == 0 && volume == 0);
+
+	assert (BKContextSeek (ctx, BKTimeMake (4000, 0)) == 0);
+	assert (BKTimeGetTime (ctx -> currentTime) == 4000);
+
+	BKDispose (& unit);
+	BKDispose (ctx);
+
+	// check seeking advances the same state as generating
+
+	BKContext * seekCtx;
+	BKTrack * seekTrack, * noiseTrack, * seekNoiseTrack;
+	BKInt vibrato [2] = {12, 3 * BK_FINT20_UNIT};
+	BKInt arpeggio [3] = {2, 0, 7};
+	BKTime seekTime = BKTimeMake (44100 * 3 + 17, 0);
+	Checksum sum = {0};
+
+	BKContextAlloc (& ctx, 2, 44100);
+	BKContextAlloc (& seekCtx, 2, 44100);
+	BKTrackAlloc (& track, BK_SQUARE);
+	BKTrackAlloc (& seekTrack, BK_SQUARE);
+	BKTrackAlloc (& noiseTrack, BK_NOISE);
+	BKTrackAlloc (& seekNoiseTrack, BK_NOISE);
+
+	BKTrack * seekTracks [4] = {track, noiseTrack, seekTrack, seekNoiseTrack};
+
+	for (BKInt i = 0; i < 4; i ++) {
+		BKSetAttr (seekTracks [i], BK_MASTER_VOLUME, BK_MAX_VOLUME / 4);
+		BKSetAttr (seekTracks [i], BK_VOLUME, BK_MAX_VOLUME);
+		BKSetAttr (seekTracks [i], BK_NOTE, (BK_C_4 + i % 2 * 12) * BK_FINT20_UNIT);
+		BKSetPtr (seekTracks [i], BK_EFFECT_VIBRATO, vibrato, sizeof (vibrato));
+		BKSetPtr (seekTracks [i], BK_ARPEGGIO, arpeggio, sizeof (arpeggio));
+		BKTrackAttach (seekTracks [i], i < 2 ? ctx : seekCtx);
+	}
+
+	BKContextScheduleAttr (ctx, track, BK_NOTE, BK_A_3 * BK_FINT20_UNIT, BKTimeMake (44100, 0));
+	BKContextScheduleAttr (seekCtx, seekTrack, BK_NOTE, BK_A_3 * BK_FINT20_UNIT, BKTimeMake (44100, 0));
+
+	assert (BKContextGenerateToTime (ctx, seekTime, (void *) writeChecksum, & sum) > 0);
+	assert (BKContextSeek (seekCtx, seekTime) == 0);
+	assert (BKContextSize (seekCtx) == 0);
+	assert (BKContextSeek (seekCtx, BK_TIME_ZERO) == BK_INVALID_VALUE);
+
+	assert (BKTimeGetTime (seekTime) == 44100 * 3 + 17);
+	assert (BKTimeIsGreaterEqual (seekCtx -> currentTime, seekTime));
+	assert (BKTimeIsEqual (ctx -> currentTime, seekCtx -> currentTime));
+	assert (ctx -> deltaTime == seekCtx -> deltaTime);
+
+	// command scheduled after 1 second has been applied
+	assert (seekCtx -> events.len == 0);
+	assert (BKGetAttr (seekTrack, BK_NOTE, & note) == 0 && note == BK_A_3 * BK_FINT20_UNIT);
+
+	for (BKInt i = 0; i < 2; i ++) {
+		BKUnit * unit = & seekTracks [i] -> unit;
+		BKUnit * seekUnit = & seekTracks [i + 2] -> unit;
+
+		assert (unit -> state -> time == seekUnit -> state -> time);
+		assert (unit -> state -> period == seekUnit -> state -> period);
+		assert (unit -> state -> phase.phase == seekUnit -> state -> phase.phase);
+		assert (unit -> state -> phase.wrapCount == seekUnit -> state -> phase.wrapCount);
+		assert (seekTracks [i] -> arpeggio.offset == seekTracks [i + 2] -> arpeggio.offset);
+	}
+
+	// check restoring snapshot generates the same frames
+
+	BKFrame restoredFrames [2 * 3000];
+	BKInt snapshotSize = BKContextSnapshotSize (ctx);
+	char * snapshot = malloc (snapshotSize);
+
+	BKContextEnd (ctx, 1000 * BK_FINT20_UNIT);
+	assert (BKContextRead (ctx, frames, 500) == 500);
+
+	assert (BKContextSnapshot (ctx, snapshot, 16) == BK_INVALID_VALUE);
+	res = BKContextSnapshot (ctx, snapshot, snapshotSize);
+	assert (res > 0 && res <= snapshotSize);
+
+	BKContextGenerate (ctx, frames, 3000);
+	assert (BKContextRestore (ctx, snapshot, snapshotSize) == 0);
+	BKContextGenerate (ctx, restoredFrames, 3000);
+	assert (memcmp (frames, restoredFrames, sizeof (restoredFrames)) == 0);
+
+	// restore from unaligned copy
+	char * unalignedSnapshot = malloc (snapshotSize + 1);
+	memcpy (& unalignedSnapshot [1], snapshot, snapshotSize);
+
+	assert (BKContextRestore (seekCtx, & unalignedSnapshot [1], snapshotSize) == 0);
+	BKContextGenerate (seekCtx, restoredFrames, 3000);
+	assert (memcmp (frames, restoredFrames, sizeof (restoredFrames)) == 0);
+
+	free (unalignedSnapshot);
+
+	BKTrackDetach (noiseTrack);
+	assert (BKContextRestore (ctx, snapshot, snapshotSize) == BK_INVALID_STATE);
+	snapshot [0] ^= 1;
+	assert (BKContextRestore (seekCtx, snapshot, snapshotSize) == BK_INVALID_VALUE);
+
+	free (snapshot);
+
+	// check units and their run states are kept contiguous when detaching
+
+	BKContext * clockCtx;
+
+	BKContextAlloc (& clockCtx, 2, 44100);
+
+	for (BKInt i = 0; i < 4; i ++) {
+		BKTrackDetach (seekTracks [i]);
+		assert (seekTracks [i] -> unit.state == & seekTracks [i] -> unit.ownState);
+		assert (BKUnitAttach (& seekTracks [i] -> unit, clockCtx) == 0);
+		BKSetAttr (& seekTracks [i] -> unit, BK_PERIOD, (i + 1) * BK_FINT20_UNIT);
+	}
+
+	BKUnitDetach (& seekTracks [1] -> unit);
+	assert (clockCtx -> units.len == 3);
+	assert (clockCtx -> unitStates.len == 3);
+
+	for (BKUInt i = 0; i < clockCtx -> units.len; i ++) {
+		BKUnit * unit = ((BKUnit **) clockCtx -> units.items) [i];
+
+		assert (unit != & seekTracks [1] -> unit);
+		assert (unit -> unitIndex == i);
+		assert (unit -> state == & ((BKUnitRunState *) clockCtx -> unitStates.items) [i]);
+	}
+
+	BKDispose (clockCtx);
+
+	for (BKInt i = 0; i < 4; i ++) {
+		assert (seekTracks [i] -> unit.ctx == NULL);
+		assert (seekTracks [i] -> unit.state == & seekTracks [i] -> unit.ownState);
+		assert (seekTracks [i] -> unit.ownState.period == (i + 1) * BK_FINT20_UNIT);
+	}
+
+	// check clocks tick at their periods and in order of the clock list
+
+	BKClock * clocks [64];
+	ClockInfo clockInfos [64];
+	BKInt clockLog [8192];
+	BKInt clockLogSize = 0;
+	BKInt clockTicks [64] = {0};
+
+	BKContextAlloc (& clockCtx, 2, 44100);
+
+	for (BKInt i = 0; i < 64; i ++) {
+		BKCallback callback = {(BKCallbackFunc) logClockTick, & clockInfos [i]};
+
+		clockInfos [i].index   = i;
+		clockInfos [i].log     = clockLog;
+		clockInfos [i].logSize = & clockLogSize;
+
+		BKClockAlloc (& clocks [i], BKTimeMake (100 + (i % 7) * 50, 0), & callback);
+		// every second clock is inserted before the previous one
+		assert (BKClockAttach (clocks [i], clockCtx, i % 2 ? clocks [i - 1] : NULL) == 0);
+	}
+
+	BKContextGenerate (clockCtx, frames, 1000);
+
+	for (BKInt i = 0; i < clockLogSize; i ++)
+		clockTicks [clockLog [i]] ++;
+
+	for (BKInt i = 0; i < 64; i ++)
+		assert (clockTicks [i] == (1000 - 1) / (100 + (i % 7) * 50) + 1);
+
+	// first ticks at time 0 in list order
+	for (BKInt i = 0; i < 64; i ++)
+		assert (clockLog [i] == (i % 2 ? i - 1 : i + 1));
+
+	BKClockDetach (clocks [10]);
+	BKClockReset (clocks [20]);
+	clockLogSize = 0;
+	BKContextGenerate (clockCtx, frames, 1);
+
+	memset (clockTicks, 0, sizeof (clockTicks));
+
+	for (BKInt i = 0; i < clockLogSize; i ++)
+		clockTicks [clockLog [i]] ++;
+
+	assert (clockTicks [10] == 0 && clockTicks [20] == 1);
+
+	for (BKInt i = 0; i < 64; i ++)
+		BKDispose (clocks [i]);
+
+	BKDispose (clockCtx);
+
+	for (BKInt i = 0; i < 4; i ++)
+		BKDispose (seekTracks [i]);
+
+	// check tone period table
+
+	for (BKInt note = BK_MIN_NOTE; note <= BK_MAX_NOTE; note ++) {
+		BKUInt index = (note - BK_MIN_NOTE) << BK_TONE_TABLE_SHIFT;
+
+		assert (ctx -> tonePeriods [index] == BKTonePeriodLookup (note << BK_FINT20_SHIFT, ctx -> sampleRate));
+	}
+
+	// fractional tones are rounded to 1/64 semitone
+
+	BKFInt20 toneStep = 1 << (BK_FINT20_SHIFT - BK_TONE_TABLE_SHIFT);
+
+	for (BKFInt20 tone = BK_MIN_NOTE << BK_FINT20_SHIFT; tone <= BK_MAX_NOTE << BK_FINT20_SHIFT; tone += toneStep) {
+		BKFUInt20 period = BKTonePeriodLookup (tone, ctx -> sampleRate);
+
+		assert (BKContextTonePeriod (ctx, tone) == period);
+
+		if (tone > BK_MIN_NOTE << BK_FINT20_SHIFT)
+			assert (BKContextTonePeriod (ctx, tone - toneStep / 2) == period);
+
+		if (tone < BK_MAX_NOTE << BK_FINT20_SHIFT)
+			assert (BKContextTonePeriod (ctx, tone + toneStep / 2 - 1) == period);
+	}
+
+	// tones out of range are clamped
+
+	BKFInt20 outOfRange [] = {BK_MIN_PIANO_TONE, BK_MIN_NOTE - 1, BK_MAX_NOTE + 1, BK_MAX_NOTE + BK_MAX_PIANO_TONE};
+
+	for (BKInt i = 0; i < 4; i ++) {
+		BKFInt20 tone = outOfRange [i] << BK_FINT20_SHIFT;
+
+		assert (BKContextTonePeriod (ctx, tone) == BKTonePeriodLookup (tone, ctx -> sampleRate));
+	}
+
+	assert (BKContextTonePeriod (ctx, BK_MIN_PIANO_TONE << BK_FINT20_SHIFT) == ctx -> tonePeriods [0]);
+	assert (BKContextTonePeriod (ctx, (BK_MAX_NOTE + 1) << BK_FINT20_SHIFT) == ctx -> tonePeriods [BK_TONE_TABLE_SIZE - 1]);
+
+	BKDispose (seekCtx);
+	BKDispose (ctx);
+
 	return 0;
 }
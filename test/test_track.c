@@ -32,12 +32,284 @@ int main (int argc, char const * argv [])
 
 	assert (res == 0);
 
+	// check pan gains of unit volumes
+
+	BKFrame frames [512 * 2];
+
+	BKSetAttr (track, BK_MASTER_VOLUME, BK_MAX_VOLUME);
+	BKSetAttr (track, BK_VOLUME, BK_MAX_VOLUME / 2);
+	BKSetAttr (track, BK_PANNING, -BK_MAX_VOLUME / 4);
+	BKSetAttr (track, BK_NOTE, BK_A_4 * BK_FINT20_UNIT);
+	BKContextGenerate (ctx, frames, 512);
+
+	BKInt volume = (BK_MAX_VOLUME / 2 * BK_MAX_VOLUME) >> BK_VOLUME_SHIFT;
+
+	assert (track -> unit.state -> volume [0] == volume);
+	assert (track -> unit.state -> volume [1] == ((BK_MAX_VOLUME - BK_MAX_VOLUME / 4) * volume) >> BK_VOLUME_SHIFT);
+
+	BKSetAttr (track, BK_PANNING, 0);
+
+	// render past buffered frames
+	for (BKInt i = 0; i < 3; i ++)
+		BKContextGenerate (ctx, frames, 512);
+
+	assert (track -> unit.state -> volume [0] == volume);
+	assert (track -> unit.state -> volume [1] == volume);
+
 	BKTrackDetach (track);
 
 	assert (track -> unit.ctx == NULL);
 
 	BKDispose (track);
+
+	// check voice pool
+
+	BKVoicePool pool;
+	BKInt value;
+
+	res = BKVoicePoolInit (& pool, 0, BK_SQUARE);
+
+	assert (res == BK_INVALID_VALUE);
+
+	res = BKVoicePoolInit (& pool, 2, BK_SQUARE);
+
+	assert (res == 0);
+	assert (BKVoicePoolNoteOn (& pool, BK_C_4 * BK_FINT20_UNIT) == BK_INVALID_STATE);
+
+	res = BKVoicePoolAttach (& pool, ctx);
+
+	assert (res == 0);
+	assert (BKVoicePoolNoteOn (& pool, BK_C_4 * BK_FINT20_UNIT) == 0);
+	assert (BKVoicePoolNoteOn (& pool, BK_E_4 * BK_FINT20_UNIT) == 1);
+
+	BKGetAttr (& pool, BK_NUM_ACTIVE_VOICES, & value);
+
+	assert (value == 2);
+
+	// steals oldest voice
+
+	assert (BKVoicePoolNoteOn (& pool, BK_G_4 * BK_FINT20_UNIT) == 0);
+	assert (pool.voices [0].note == BK_G_4 * BK_FINT20_UNIT);
+
+	// released voice is parked after next tick
+
+	BKVoicePoolNoteOff (& pool, BK_E_4 * BK_FINT20_UNIT);
+	BKContextGenerate (ctx, frames, 512);
+
+	BKGetAttr (& pool, BK_NUM_ACTIVE_VOICES, & value);
+
+	assert (value == 1);
+	assert (pool.voices [1].track.unit.ctx == NULL);
+
+	// parked voice is reused
+
+	assert (BKVoicePoolNoteOn (& pool, BK_A_4 * BK_FINT20_UNIT) == 1);
+
+	// steals quietest voice even if it is not the oldest
+
+	res = BKSetAttr (& pool, BK_VOICE_STEALING, BK_STEAL_QUIETEST);
+
+	assert (res == 0);
+
+	for (BKInt i = 0; i < 2; i ++)
+		BKSetAttr (& pool.voices [i].track, BK_MASTER_VOLUME, BK_MAX_VOLUME);
+
+	BKSetAttr (& pool.voices [0].track, BK_VOLUME, BK_MAX_VOLUME / 2);
+	BKSetAttr (& pool.voices [1].track, BK_VOLUME, BK_MAX_VOLUME / 4);
+	BKContextGenerate (ctx, frames, 512);
+
+	assert (BKVoicePoolNoteOn (& pool, BK_B_4 * BK_FINT20_UNIT) == 1);
+	assert (pool.voices [1].note == BK_B_4 * BK_FINT20_UNIT);
+	assert (pool.voices [0].note == BK_G_4 * BK_FINT20_UNIT);
+
+	BKVoicePoolDetach (& pool);
+
+	BKGetAttr (& pool, BK_NUM_ACTIVE_VOICES, & value);
+
+	assert (value == 0);
+	assert (pool.voices [0].track.unit.ctx == NULL);
+
+	BKDispose (& pool);
 	BKDispose (ctx);
 
+	// check sleeping of silent tracks
+
+	BKContext ctxs [2];
+	BKTrack   tracks [2];
+	BKFrame   frames2 [512 * 2];
+	BKInt     slide [2] = {1, 0};
+
+	for (BKInt i = 0; i < 2; i ++) {
+		BKContextInit (& ctxs [i], 2, 44100);
+		BKTrackInit (& tracks [i], BK_SQUARE);
+		BKTrackAttach (& tracks [i], & ctxs [i]);
+		BKSetAttr (& tracks [i], BK_VOLUME, BK_MAX_VOLUME / 2);
+		BKSetAttr (& tracks [i], BK_NOTE, BK_A_4 * BK_FINT20_UNIT);
+	}
+
+	// keep second track awake with an effect which does not change its output
+	BKSetPtr (& tracks [1], BK_EFFECT_VOLUME_SLIDE, slide, sizeof (slide));
+
+	BKContextGenerate (& ctxs [0], frames, 512);
+	BKContextGenerate (& ctxs [1], frames2, 512);
+
+	for (BKInt i = 0; i < 2; i ++)
+		BKSetAttr (& tracks [i], BK_NOTE, BK_NOTE_MUTE);
+
+	BKContextGenerate (& ctxs [0], frames, 512);
+	BKContextGenerate (& ctxs [1], frames2, 512);
+
+	assert (tracks [0].unit.object.flags & BKUnitFlagSleeping);
+	assert ((tracks [1].unit.object.flags & BKUnitFlagSleeping) == 0);
+	assert (ctxs [0].units.len == 0);
+	assert (tracks [0].unit.state == & tracks [0].unit.ownState);
+
+	// channels still advance
+	assert (memcmp (frames, frames2, sizeof (frames)) == 0);
+
+	for (BKInt i = 0; i < 2; i ++)
+		BKSetAttr (& tracks [i], BK_NOTE, BK_C_4 * BK_FINT20_UNIT);
+
+	assert ((tracks [0].unit.object.flags & BKUnitFlagSleeping) == 0);
+	assert (ctxs [0].units.len == 1);
+	assert (tracks [0].unit.state == ctxs [0].unitStates.items);
+
+	BKContextGenerate (& ctxs [0], frames, 512);
+	BKContextGenerate (& ctxs [1], frames2, 512);
+
+	assert (memcmp (frames, frames2, sizeof (frames)) == 0);
+
+	for (BKInt i = 0; i < 2; i ++) {
+		BKDispose (& tracks [i]);
+		BKDispose (& ctxs [i]);
+	}
+
+	// check tracks ticked in batch against tracks ticked separately
+
+	BKTrack batchTracks [2][4];
+	BKInt   vibrato [3]   = {12, 2 * BK_FINT20_UNIT, 20};
+	BKInt   tremolo [3]   = {8, BK_MAX_VOLUME / 4, 10};
+	BKInt   portamento    = 3;
+	BKInt   panningSlide  = 10;
+
+	for (BKInt i = 0; i < 2; i ++) {
+		BKContextInit (& ctxs [i], 2, 44100);
+	}
+
+	res = BKSetAttr (& ctxs [1], BK_BATCH_TICKS, 1);
+
+	assert (res == 0);
+
+	for (BKInt i = 0; i < 2; i ++) {
+		for (BKInt j = 0; j < 4; j ++) {
+			BKTrack * batchTrack = & batchTracks [i][j];
+
+			BKTrackInit (batchTrack, BK_SQUARE);
+			BKTrackAttach (batchTrack, & ctxs [i]);
+			BKSetAttr (batchTrack, BK_MASTER_VOLUME, BK_MAX_VOLUME / 4);
+			BKSetAttr (batchTrack, BK_VOLUME, BK_MAX_VOLUME / 2);
+			BKSetAttr (batchTrack, BK_NOTE, (BK_C_4 + j * 4) * BK_FINT20_UNIT);
+		}
+
+		BKSetPtr (& batchTracks [i][0], BK_EFFECT_VIBRATO, vibrato, sizeof (vibrato));
+		BKSetPtr (& batchTracks [i][1], BK_EFFECT_TREMOLO, tremolo, sizeof (tremolo));
+		BKSetPtr (& batchTracks [i][2], BK_EFFECT_PORTAMENTO, & portamento, sizeof (portamento));
+		BKSetPtr (& batchTracks [i][3], BK_EFFECT_PANNING_SLIDE, & panningSlide, sizeof (panningSlide));
+		BKSetAttr (& batchTracks [i][3], BK_PANNING, BK_MAX_VOLUME / 2);
+	}
+
+	res = BKSetAttr (& ctxs [1], BK_BATCH_TICKS, 0);
+
+	assert (res == BK_INVALID_STATE);
+
+	for (BKInt n = 0; n < 40; n ++) {
+		for (BKInt i = 0; i < 2; i ++) {
+			if (n % 8 == 4) {
+				BKSetAttr (& batchTracks [i][2], BK_NOTE, (BK_C_4 + n % 12) * BK_FINT20_UNIT);
+				BKSetAttr (& batchTracks [i][3], BK_PANNING, n % 16 == 4 ? -BK_MAX_VOLUME / 2 : BK_MAX_VOLUME / 2);
+			}
+
+			// let second track sleep and wake it again
+			if (n == 10)
+				BKSetAttr (& batchTracks [i][1], BK_NOTE, BK_NOTE_MUTE);
+
+			if (n == 20)
+				BKSetAttr (& batchTracks [i][1], BK_NOTE, BK_G_4 * BK_FINT20_UNIT);
+		}
+
+		BKContextGenerate (& ctxs [0], frames, 512);
+		BKContextGenerate (& ctxs [1], frames2, 512);
+
+		assert (memcmp (frames, frames2, sizeof (frames)) == 0);
+	}
+
+	// states are written back into tracks when detached
+	BKInt vibratos [2][3];
+
+	for (BKInt i = 0; i < 2; i ++)
+		BKTrackDetach (& batchTracks [i][0]);
+
+	for (BKInt i = 0; i < 2; i ++)
+		BKTrackGetEffect (& batchTracks [i][0], BK_EFFECT_VIBRATO, vibratos [i], sizeof (vibratos [i]));
+
+	assert (memcmp (vibratos [0], vibratos [1], sizeof (vibratos [0])) == 0);
+	assert (memcmp (& batchTracks [0][0].vibrato, & batchTracks [1][0].vibrato, sizeof (BKIntervalState)) == 0);
+
+	for (BKInt i = 0; i < 2; i ++) {
+		for (BKInt j = 0; j < 4; j ++)
+			BKDispose (& batchTracks [i][j]);
+
+		BKDispose (& ctxs [i]);
+	}
+
+	// check baked envelope against interpolated envelope
+
+	BKSequencePhase phases [] = {{0, 10}, {7, 200}, {13, -51}, {0, 80}, {5, 80}, {9, 30}, {0, 3}, {11, 0}};
+	BKSequence * sequences [2];
+	BKSequenceState states [2];
+	BKUInt seed = 1;
+
+	res = BKSequenceCreate (& sequences [0], & BKSequenceFuncsEnvelope, phases, 8, 3, 3);
+
+	assert (res == 0);
+	assert (sequences [0] -> bakedSteps != NULL);
+
+	BKSequenceCopy (& sequences [1], sequences [0]);
+
+	// interpolate only
+	free (sequences [1] -> bakedSteps);
+	sequences [1] -> bakedSteps = NULL;
+
+	memset (states, 0, sizeof (states));
+
+	for (BKInt i = 0; i < 2; i ++)
+		BKSequenceStateSetSequence (& states [i], sequences [i]);
+
+	for (BKInt n = 0; n < 5000; n ++) {
+		BKInt results [2];
+		BKInt action;
+
+		seed = seed * 1103515245 + 12345;
+		action = (seed >> 16) % 64;
+
+		for (BKInt i = 0; i < 2; i ++) {
+			switch (action) {
+				case 0:  results [i] = BKSequenceStateSetPhase (& states [i], BK_SEQUENCE_PHASE_ATTACK); break;
+				case 1:  results [i] = BKSequenceStateSetPhase (& states [i], BK_SEQUENCE_PHASE_RELEASE); break;
+				case 2:  results [i] = BKSequenceStateSetPhase (& states [i], BK_SEQUENCE_PHASE_MUTE); break;
+				case 3:  results [i] = BKSequenceStateSetValue (& states [i], (seed >> 8) % 100); break;
+				default: results [i] = BKSequenceStateStep (& states [i], BK_SEQUENCE_STEP_MAX); break;
+			}
+		}
+
+		assert (results [0] == results [1]);
+		assert (states [0].value == states [1].value);
+	}
+
+	BKSequenceStateSetSequence (& states [0], NULL);
+	BKSequenceStateSetSequence (& states [1], NULL);
+	BKSequenceDispose (sequences [0]);
+	BKSequenceDispose (sequences [1]);
+
 	return 0;
 }
@@ -3,6 +3,7 @@
 #include "test.h"
 #include "BKWaveFileReader.h"
 #include "BKWaveFileWriter.h"
+#include "BKData_internal.h"
 
 int main (int argc, char const * argv [])
 {
@@ -75,6 +76,8 @@ int main (int argc, char const * argv [])
 
 	assert (res == 0);
 
+	long dataOffset = ftell (file);
+
 	assert (numChannels == readNumChannels);
 	assert (sampleRate == readSampleRate);
 	assert (numFrames * 100 == readNumFrames);
@@ -89,6 +92,55 @@ int main (int argc, char const * argv [])
 
 	BKDispose (& reader);
 
+	BKData data, mappedData;
+
+	res = BKDataInit (& data);
+
+	assert (res == 0);
+
+	res = BKDataInit (& mappedData);
+
+	assert (res == 0);
+
+	rewind (file);
+	res = BKDataLoadWAVEMapped (& mappedData, file);
+
+	assert (res == 0);
+
+	assert (mappedData.numFrames == readNumFrames);
+	assert (mappedData.numChannels == readNumChannels);
+	assert (mappedData.sampleRate == readSampleRate);
+	assert (memcmp (mappedData.frames, frames, readNumChannels * readNumFrames * sizeof (BKFrame)) == 0);
+
+	// raw frames behind header
+	fseek (file, dataOffset, SEEK_SET);
+	res = BKDataLoadRawMapped (& data, file, readNumChannels, BK_16_BIT_SIGNED | BK_LITTLE_ENDIAN);
+
+	assert (res == 0);
+
+	assert (data.numFrames == readNumFrames);
+	assert (memcmp (data.frames, frames, readNumChannels * readNumFrames * sizeof (BKFrame)) == 0);
+
+	// data sizes of 4 GiB or more are rejected
+	assert (BKDataCheckSize (1 << 20) == 0);
+	assert (BKDataCheckSize (-1) == BK_INVALID_VALUE);
+#if INTPTR_MAX > UINT32_MAX
+	assert (BKDataCheckSize ((BKUInt) -1) == 0);
+	assert (BKDataCheckSize ((BKSize) 1 << 32) == BK_INVALID_VALUE);
+#endif
+
+	// frames are copied when replaced
+	res = BKDataSetFrames (& data, frames, readNumFrames, readNumChannels, 1);
+
+	assert (res == 0);
+#if BK_USE_MMAP
+	assert (mappedData.mapping != NULL);
+#endif
+	assert (data.mapping == NULL);
+
+	BKDispose (& mappedData);
+	BKDispose (& data);
+
 	fclose (file);
 	unlink (filename);
 